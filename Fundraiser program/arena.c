@@ -0,0 +1,135 @@
+/**
+    @file arena.c
+    @author Sachi Vyas (smvyas)
+    A program that: Hands out memory for a group from a few large chunks, so records are stored next to each
+    other, allocating them is a pointer bump and the whole group is freed by releasing the chunks.
+ */
+#include "arena.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+
+/** Size of the first chunk an arena takes */
+#define FIRST_CHUNK_SIZE 65536
+/** Largest chunk an arena takes, unless one allocation needs more */
+#define MAX_CHUNK_SIZE 67108864
+/** Alignment of every allocation */
+#define ARENA_ALIGN 16
+/** Size of the smallest block handed out by arenaBlock */
+#define SMALLEST_BLOCK 16
+
+/**
+    Initializes an empty arena. No memory is taken until the first allocation.
+    @param *arena the arena to initialize
+ */
+void initArena( Arena *arena )
+{
+    arena -> chunks = NULL;
+    arena -> nextSize = FIRST_CHUNK_SIZE;
+    for (int i = 0; i < ARENA_CLASSES; i++) {
+        arena -> freeBlocks[i] = NULL;
+    }
+}
+
+/**
+    Frees every chunk of the arena at once, along with everything that was allocated from it.
+    @param *arena the arena to free
+ */
+void freeArena( Arena *arena )
+{
+    ArenaChunk *chunk = arena -> chunks;
+    while (chunk != NULL) {
+        ArenaChunk *next = chunk -> next;
+        free(chunk);
+        chunk = next;
+    }
+    initArena(arena);
+}
+
+/**
+    Returns the number of bytes the chunk header takes, rounded up so the data after it stays aligned.
+    @return the size of the header
+ */
+static size_t headerSize( void )
+{
+    return (sizeof(ArenaChunk) + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+}
+
+/**
+    Allocates storage from the arena. It can't be freed on its own, only with the whole arena.
+    @param *arena the arena to allocate from
+    @param size the number of bytes needed
+    @return a pointer to the storage, aligned for any record type
+ */
+void *arenaAlloc( Arena *arena, size_t size )
+{
+    size = (size + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+    ArenaChunk *chunk = arena -> chunks;
+    if (chunk == NULL || chunk -> size - chunk -> used < size) {
+        size_t chunkSize = arena -> nextSize;
+        while (chunkSize < size) {
+            chunkSize *= 2;
+        }
+        chunk = (ArenaChunk *)malloc(headerSize() + chunkSize);
+        if (chunk == NULL) {
+            fprintf(stderr, "Memory allocation issue.\n");
+            exit(EXIT_FAILURE);
+        }
+        chunk -> size = chunkSize;
+        chunk -> used = 0;
+        chunk -> next = arena -> chunks;
+        arena -> chunks = chunk;
+        if (arena -> nextSize < MAX_CHUNK_SIZE) {
+            arena -> nextSize *= 2;
+        }
+    }
+    void *p = (char *)chunk + headerSize() + chunk -> used;
+    chunk -> used += size;
+    return p;
+}
+
+/**
+    Finds the free list a block size belongs to.
+    @param size the size of the block, a power of two of at least 16
+    @return the index of the free list for the size
+ */
+static int sizeClass( size_t size )
+{
+    int c = 0;
+    while ((size_t)SMALLEST_BLOCK << c < size) {
+        c++;
+    }
+    return c;
+}
+
+/**
+    Allocates a power-of-two sized block from the arena, reusing a released block of the same size if there is one.
+    @param *arena the arena to allocate from
+    @param size the number of bytes needed, a power of two of at least 16
+    @return a pointer to the block
+ */
+void *arenaBlock( Arena *arena, size_t size )
+{
+    int c = sizeClass(size);
+    void *block = arena -> freeBlocks[c];
+    if (block != NULL) {
+        // a released block holds the pointer to the next free block of its size
+        memcpy(&arena -> freeBlocks[c], block, sizeof(void *));
+        return block;
+    }
+    return arenaAlloc(arena, (size_t)SMALLEST_BLOCK << c);
+}
+
+/**
+    Gives a block from arenaBlock back to the arena so a later arenaBlock of the same size can reuse it.
+    @param *arena the arena the block came from
+    @param *block the block to give back
+    @param size the size the block was allocated with
+ */
+void arenaRelease( Arena *arena, void *block, size_t size )
+{
+    int c = sizeClass(size);
+    memcpy(block, &arena -> freeBlocks[c], sizeof(void *));
+    arena -> freeBlocks[c] = block;
+}
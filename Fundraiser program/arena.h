@@ -0,0 +1,64 @@
+/**
+    @file arena.h
+    @author Sachi Vyas (smvyas)
+    A program that: The prototype for arena.c
+ */
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+
+#ifndef ARENA_H
+#define ARENA_H
+
+/** Number of block sizes the arena keeps free lists for, from 16 bytes up to 16 << (ARENA_CLASSES - 1) */
+#define ARENA_CLASSES 28
+
+/** Struct for one large chunk of memory that the arena hands out pieces of */
+struct ArenaChunkStruct {
+    struct ArenaChunkStruct *next;
+    size_t size;
+    size_t used;
+};
+typedef struct ArenaChunkStruct ArenaChunk;
+
+/** Struct for the arena, which owns every chunk and the free lists of power-of-two blocks */
+struct ArenaStruct {
+    ArenaChunk *chunks;
+    size_t nextSize;
+    void *freeBlocks[ARENA_CLASSES];
+};
+typedef struct ArenaStruct Arena;
+
+/**
+    Initializes an empty arena. No memory is taken until the first allocation.
+    @param *arena the arena to initialize
+ */
+void initArena( Arena *arena );
+/**
+    Frees every chunk of the arena at once, along with everything that was allocated from it.
+    @param *arena the arena to free
+ */
+void freeArena( Arena *arena );
+/**
+    Allocates storage from the arena. It can't be freed on its own, only with the whole arena.
+    @param *arena the arena to allocate from
+    @param size the number of bytes needed
+    @return a pointer to the storage, aligned for any record type
+ */
+void *arenaAlloc( Arena *arena, size_t size );
+/**
+    Allocates a power-of-two sized block from the arena, reusing a released block of the same size if there is one.
+    @param *arena the arena to allocate from
+    @param size the number of bytes needed, a power of two of at least 16
+    @return a pointer to the block
+ */
+void *arenaBlock( Arena *arena, size_t size );
+/**
+    Gives a block from arenaBlock back to the arena so a later arenaBlock of the same size can reuse it.
+    @param *arena the arena the block came from
+    @param *block the block to give back
+    @param size the size the block was allocated with
+ */
+void arenaRelease( Arena *arena, void *block, size_t size );
+
+#endif
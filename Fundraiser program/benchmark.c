@@ -0,0 +1,441 @@
+/**
+    @file benchmark.c
+    @author Sachi Vyas (smvyas)
+    A program that: Runs the fundraiser program on a stream of commands and reports how long it takes to load,
+    how fast each kind of command runs, the median and 99th percentile time of each kind, and the most memory
+    the program used.
+ */
+#define _XOPEN_SOURCE 700
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+/** Number of command line arguments needed after the options, counting the program name */
+#define MIN_ARGS 5
+/** Number of sales timed together, unless -b says otherwise */
+#define DEFAULT_BATCH 1000
+/** Line sent after each timed command; the program answers it as an invalid command */
+#define SYNC_LINE "bench-sync\n"
+/** What the program prints for SYNC_LINE, which marks the end of the output of the commands before it */
+#define SYNC_REPLY "cmd> bench-sync\nInvalid command\n\n"
+/** Bytes read from the program at a time */
+#define READ_SIZE 65536
+/** Number of samples a kind of command has room for at first */
+#define INITIAL_SAMPLES 64
+/** Nanoseconds in a second */
+#define NANOS 1000000000.0
+/** Nanoseconds in a microsecond */
+#define NANOS_PER_MICRO 1000.0
+/** Nanoseconds in a millisecond */
+#define NANOS_PER_MILLI 1000000.0
+/** Percent for the median */
+#define MEDIAN 50
+/** Percent for the tail latency that is reported */
+#define TAIL 99
+/** Percent for the whole */
+#define PERCENT 100
+
+/** Struct for the timings of one kind of command */
+struct KindStruct {
+    char const *name;
+    long long count;
+    double totalNanos;
+    double *samples;
+    int sampleCount;
+    int sampleCap;
+};
+typedef struct KindStruct Kind;
+
+/** The kinds of command, with names that are prefixes of their commands; longer names come first */
+static Kind kinds[] = {
+    { "sale" }, { "load sales" }, { "list items" }, { "list item names" }, { "list member names" },
+    { "list members" }, { "list topsellers" }, { "list member" }, { "search ignorecase item" },
+    { "search ignorecase member" }, { "search item" }, { "search member" }, { "other" }
+};
+
+/** Struct for the running fundraiser program and the input waiting to be sent to it */
+struct ChildStruct {
+    pid_t pid;
+    int in;
+    int out;
+    char *pending;
+    size_t pendingLen;
+    size_t pendingCap;
+    char tail[sizeof(SYNC_REPLY)];
+    size_t tailLen;
+};
+typedef struct ChildStruct Child;
+
+/**
+    Returns the time from a clock that only goes forward.
+    @return the time in nanoseconds
+ */
+static double now( void )
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * NANOS + ts.tv_nsec;
+}
+
+/**
+    Finds the kind of a command.
+    @param *line the command
+    @return the kind
+ */
+static Kind *classify( char const *line )
+{
+    int last = sizeof(kinds) / sizeof(kinds[0]) - 1;
+    for (int i = 0; i < last; i++) {
+        size_t len = strlen(kinds[i].name);
+        if (strncmp(line, kinds[i].name, len) == 0 && (line[len] == '\0' || line[len] == ' ')) {
+            return &kinds[i];
+        }
+    }
+    return &kinds[last];
+}
+
+/**
+    Adds the time a group of commands of one kind took.
+    @param *kind the kind of the commands
+    @param count the number of commands
+    @param nanos how long they took together
+ */
+static void addTiming( Kind *kind, int count, double nanos )
+{
+    if (kind -> sampleCount == kind -> sampleCap) {
+        kind -> sampleCap = kind -> sampleCap == 0 ? INITIAL_SAMPLES : kind -> sampleCap * 2;
+        kind -> samples = realloc(kind -> samples, kind -> sampleCap * sizeof(double));
+        if (kind -> samples == NULL) {
+            fprintf(stderr, "Memory allocation issue.\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+    kind -> samples[kind -> sampleCount++] = nanos / count;
+    kind -> count += count;
+    kind -> totalNanos += nanos;
+}
+
+/**
+    Adds text to the input waiting to be sent to the program.
+    @param *child the program
+    @param *text the text to add
+ */
+static void queueInput( Child *child, char const *text )
+{
+    size_t len = strlen(text);
+    if (child -> pendingLen + len > child -> pendingCap) {
+        while (child -> pendingLen + len > child -> pendingCap) {
+            child -> pendingCap = child -> pendingCap == 0 ? READ_SIZE : child -> pendingCap * 2;
+        }
+        child -> pending = realloc(child -> pending, child -> pendingCap);
+        if (child -> pending == NULL) {
+            fprintf(stderr, "Memory allocation issue.\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+    memcpy(child -> pending + child -> pendingLen, text, len);
+    child -> pendingLen += len;
+}
+
+/**
+    Checks output from the program for SYNC_REPLY, keeping the end of it in case the reply is split
+    between reads.
+    @param *child the program
+    @param *data the output
+    @param size the number of bytes of output
+    @return true if the reply was found
+ */
+static bool findReply( Child *child, char const *data, size_t size )
+{
+    size_t replyLen = strlen(SYNC_REPLY);
+    char joined[sizeof(SYNC_REPLY) * 2];
+    // the reply could start in the saved tail and end in the new data
+    size_t head = size < replyLen ? size : replyLen;
+    memcpy(joined, child -> tail, child -> tailLen);
+    memcpy(joined + child -> tailLen, data, head);
+    size_t joinedLen = child -> tailLen + head;
+    bool found = false;
+    for (size_t i = 0; i + replyLen <= joinedLen && !found; i++) {
+        found = memcmp(joined + i, SYNC_REPLY, replyLen) == 0;
+    }
+    for (size_t i = 0; i + replyLen <= size && !found; i++) {
+        found = data[i] == SYNC_REPLY[0] && memcmp(data + i, SYNC_REPLY, replyLen) == 0;
+    }
+    if (found) {
+        child -> tailLen = 0;
+        return true;
+    }
+    // keep the last replyLen - 1 bytes seen
+    size_t keep = replyLen - 1;
+    if (size >= keep) {
+        memcpy(child -> tail, data + size - keep, keep);
+        child -> tailLen = keep;
+    }
+    else {
+        size_t old = child -> tailLen + size > keep ? keep - size : child -> tailLen;
+        memmove(child -> tail, child -> tail + child -> tailLen - old, old);
+        memcpy(child -> tail + old, data, size);
+        child -> tailLen = old + size;
+    }
+    return false;
+}
+
+/**
+    Sends the waiting input to the program and reads its output until the answer to SYNC_LINE comes back.
+    Output is read while input is written, so neither side waits on the other.
+    @param *child the program
+ */
+static void runUntilSync( Child *child )
+{
+    char buffer[READ_SIZE];
+    size_t sent = 0;
+    while (true) {
+        struct pollfd fds[2] = { { child -> out, POLLIN, 0 }, { child -> in, POLLOUT, 0 } };
+        int nfds = sent < child -> pendingLen ? 2 : 1;
+        if (poll(fds, nfds, -1) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            perror("poll");
+            exit(EXIT_FAILURE);
+        }
+        if (nfds == 2 && (fds[1].revents & (POLLOUT | POLLERR | POLLHUP)) != 0) {
+            ssize_t n = write(child -> in, child -> pending + sent, child -> pendingLen - sent);
+            if (n < 0 && errno != EAGAIN && errno != EINTR) {
+                fprintf(stderr, "fundraiser stopped reading its input\n");
+                exit(EXIT_FAILURE);
+            }
+            if (n > 0) {
+                sent += n;
+            }
+        }
+        if ((fds[0].revents & (POLLIN | POLLERR | POLLHUP)) != 0) {
+            ssize_t n = read(child -> out, buffer, sizeof(buffer));
+            if (n <= 0 && !(n < 0 && (errno == EAGAIN || errno == EINTR))) {
+                fprintf(stderr, "fundraiser exited before answering\n");
+                exit(EXIT_FAILURE);
+            }
+            if (n > 0 && findReply(child, buffer, n)) {
+                child -> pendingLen = 0;
+                return;
+            }
+        }
+    }
+}
+
+/**
+    Sends the queued commands followed by SYNC_LINE and records how long the program took to answer.
+    @param *child the program
+    @param *kind the kind of the queued commands
+    @param count the number of queued commands
+ */
+static void timeCommands( Child *child, Kind *kind, int count )
+{
+    queueInput(child, SYNC_LINE);
+    double start = now();
+    runUntilSync(child);
+    addTiming(kind, count, now() - start);
+}
+
+/**
+    Starts the fundraiser program with its input on a pipe and its output on a pseudo-terminal. Output to a
+    terminal is flushed after every command, so the time each command takes can be seen from here.
+    @param *child filled in with the running program
+    @param **args the program and its arguments
+ */
+static void startChild( Child *child, char *const *args )
+{
+    int pipeFds[2];
+    int master = posix_openpt(O_RDWR | O_NOCTTY);
+    if (pipe(pipeFds) != 0 || master < 0 || grantpt(master) != 0 || unlockpt(master) != 0) {
+        perror("can't set up the program's input and output");
+        exit(EXIT_FAILURE);
+    }
+    int slave = open(ptsname(master), O_RDWR | O_NOCTTY);
+    struct termios settings;
+    if (slave < 0 || tcgetattr(slave, &settings) != 0) {
+        perror("can't open the terminal");
+        exit(EXIT_FAILURE);
+    }
+    // pass the output through untouched, with no \r added before each \n
+    settings.c_oflag &= ~OPOST;
+    settings.c_lflag &= ~(ECHO | ICANON);
+    tcsetattr(slave, TCSANOW, &settings);
+
+    child -> pid = fork();
+    if (child -> pid < 0) {
+        perror("fork");
+        exit(EXIT_FAILURE);
+    }
+    if (child -> pid == 0) {
+        dup2(pipeFds[0], STDIN_FILENO);
+        dup2(slave, STDOUT_FILENO);
+        close(pipeFds[0]);
+        close(pipeFds[1]);
+        close(slave);
+        close(master);
+        execv(args[0], args);
+        perror(args[0]);
+        _exit(EXIT_FAILURE);
+    }
+    close(pipeFds[0]);
+    close(slave);
+    child -> in = pipeFds[1];
+    child -> out = master;
+    fcntl(child -> in, F_SETFL, O_NONBLOCK);
+    fcntl(child -> out, F_SETFL, O_NONBLOCK);
+    child -> pending = NULL;
+    child -> pendingLen = 0;
+    child -> pendingCap = 0;
+    child -> tailLen = 0;
+}
+
+/**
+    Closes the program's input and reads the rest of its output until it exits.
+    @param *child the program
+ */
+static void finishChild( Child *child )
+{
+    char buffer[READ_SIZE];
+    close(child -> in);
+    fcntl(child -> out, F_SETFL, 0);
+    // reading the terminal fails once the program has closed its end
+    while (read(child -> out, buffer, sizeof(buffer)) > 0) {
+    }
+    close(child -> out);
+    waitpid(child -> pid, NULL, 0);
+    free(child -> pending);
+}
+
+/**
+    Compares two samples for qsort.
+    @param *va the first sample
+    @param *vb the second sample
+    @return negative, zero or positive as the first is less than, equal to or greater than the second
+ */
+static int compareSamples( void const *va, void const *vb )
+{
+    double a = *(double const *) va;
+    double b = *(double const *) vb;
+    return a < b ? -1 : a > b;
+}
+
+/**
+    Finds a percentile of a kind's sorted samples, by the nearest rank.
+    @param *kind the kind
+    @param percent the percentile
+    @return the sample at the percentile, in microseconds
+ */
+static double percentile( Kind const *kind, int percent )
+{
+    int rank = (kind -> sampleCount * percent + PERCENT - 1) / PERCENT;
+    return kind -> samples[rank > 0 ? rank - 1 : 0] / NANOS_PER_MICRO;
+}
+
+/**
+    Runs the fundraiser program on the commands in a file and prints what it measured.
+    @param argc the number of arguments in the command line
+    @param argv [-b batch] program item-file member-file command-file
+    @return 0 if the benchmark ran
+ */
+int main( int argc, char *argv[] )
+{
+    int batch = DEFAULT_BATCH;
+    int first = 1;
+    if (argc > 2 && strcmp(argv[1], "-b") == 0) {
+        batch = atoi(argv[2]);
+        first = 3;
+    }
+    if (argc - first + 1 < MIN_ARGS || batch < 1) {
+        fprintf(stderr, "usage: benchmark [-b sales-per-timing] program item-file member-file command-file\n");
+        exit(EXIT_FAILURE);
+    }
+    FILE *commands = fopen(argv[first + 3], "r");
+    if (commands == NULL) {
+        fprintf(stderr, "Can't open file: %s\n", argv[first + 3]);
+        exit(EXIT_FAILURE);
+    }
+    signal(SIGPIPE, SIG_IGN);
+
+    char *args[] = { argv[first], argv[first + 1], argv[first + 2], NULL };
+    Child child;
+    double start = now();
+    startChild(&child, args);
+    // the first answer comes once the files are loaded
+    queueInput(&child, SYNC_LINE);
+    runUntilSync(&child);
+    double loadNanos = now() - start;
+
+    // sales are timed a batch at a time, everything else one command at a time
+    Kind *sale = &kinds[0];
+    int queuedSales = 0;
+    char *line = NULL;
+    size_t lineCap = 0;
+    ssize_t len;
+    while ((len = getline(&line, &lineCap, commands)) > 0) {
+        if (line[len - 1] != '\n') {
+            line = realloc(line, len + 2);
+            if (line == NULL) {
+                fprintf(stderr, "Memory allocation issue.\n");
+                exit(EXIT_FAILURE);
+            }
+            line[len++] = '\n';
+            line[len] = '\0';
+        }
+        if (strcmp(line, "quit\n") == 0) {
+            break;
+        }
+        line[len - 1] = '\0';
+        Kind *kind = classify(line);
+        line[len - 1] = '\n';
+        if (kind != sale && queuedSales > 0) {
+            timeCommands(&child, sale, queuedSales);
+            queuedSales = 0;
+        }
+        queueInput(&child, line);
+        if (kind != sale) {
+            timeCommands(&child, kind, 1);
+        }
+        else if (++queuedSales == batch) {
+            timeCommands(&child, sale, queuedSales);
+            queuedSales = 0;
+        }
+    }
+    if (queuedSales > 0) {
+        timeCommands(&child, sale, queuedSales);
+    }
+    free(line);
+    fclose(commands);
+    finishChild(&child);
+
+    struct rusage usage;
+    getrusage(RUSAGE_CHILDREN, &usage);
+    printf("%-26s %12.1f ms\n", "load", loadNanos / NANOS_PER_MILLI);
+    printf("%-26s %10s %12s %10s %10s\n", "command", "count", "ops/s", "p50 us", "p99 us");
+    for (size_t i = 0; i < sizeof(kinds) / sizeof(kinds[0]); i++) {
+        Kind *kind = &kinds[i];
+        if (kind -> count == 0) {
+            continue;
+        }
+        qsort(kind -> samples, kind -> sampleCount, sizeof(double), compareSamples);
+        printf("%-26s %10lld %12.1f %10.1f %10.1f\n", kind -> name, kind -> count,
+               kind -> count / (kind -> totalNanos / NANOS), percentile(kind, MEDIAN), percentile(kind, TAIL));
+        free(kind -> samples);
+    }
+    if (batch > 1 && sale -> count > 0) {
+        printf("sale latencies are means over batches of up to %d sales\n", batch);
+    }
+    printf("%-26s %12ld KiB\n", "peak RSS", usage.ru_maxrss);
+    return EXIT_SUCCESS;
+}
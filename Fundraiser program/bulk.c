@@ -0,0 +1,337 @@
+/**
+    @file bulk.c
+    @author Sachi Vyas (smvyas)
+    A program that: Loads a whole file of sale commands at once. Worker threads parse chunks of the file and
+    add up the quantities for each member and item, then the totals are recorded in the group.
+ */
+#define _POSIX_C_SOURCE 200809L
+#include "input.h"
+#include "group.h"
+#include "bulk.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+
+/** Most worker threads loadSales starts */
+#define MAX_WORKERS 16
+/** Smallest part of a sales file worth giving a worker of its own */
+#define MIN_CHUNK 1048576
+/** Length of the word sale at the start of a sale line */
+#define SALE_LEN 4
+/** Number of slots a worker's table of totals starts with, must be a power of two */
+#define INITIAL_TOTALS 1024
+/** Multiplier used to scatter (member, item) pairs across a worker's table */
+#define PAIR_HASH_MULTIPLIER 0x9E3779B97F4A7C15ull
+/** Shift that keeps the well mixed high bits of a pair hash */
+#define PAIR_HASH_SHIFT 32
+/** Marks an unused slot in a worker's table */
+#define NO_MEMBER -1
+
+/** Struct for the total quantity of one item sold by one member */
+struct PairTotalStruct {
+    int memberIndex;
+    int itemIndex;
+    long long quantity;
+};
+typedef struct PairTotalStruct PairTotal;
+
+/** Struct for the part of the file one worker parses, and what it found there */
+struct WorkerStruct {
+    Group const *group;
+    char const *start;
+    char const *end;
+    PairTotal *totals;
+    int totalCount;
+    int totalCap;
+    char const **invalid;
+    int invalidCount;
+    int invalidCap;
+    long long applied;
+};
+typedef struct WorkerStruct Worker;
+
+/**
+    Parses a sale line the way the sale command does with sscanf(cmd, "sale %8s %d %d").
+    @param *p the start of the line
+    @param *end the end of the line
+    @param *memberId filled in with the member id, at most 8 characters
+    @param *itemId set to the item id
+    @param *quantity set to the quantity sold
+    @return true if the line is a well formed sale
+ */
+static bool parseSale( char const *p, char const *end, char *memberId, int *itemId, int *quantity )
+{
+    if (end - p < SALE_LEN || strncmp(p, "sale", SALE_LEN) != 0) {
+        return false;
+    }
+    p = skipBlanks(p + SALE_LEN, end);
+    int len = 0;
+    while (p + len < end && len < MAX_ID_LEN && !isBlank(p[len])) {
+        len++;
+    }
+    if (len == 0) {
+        return false;
+    }
+    memcpy(memberId, p, len);
+    memberId[len] = '\0';
+    p = scanInt(p + len, end, itemId);
+    return p != NULL && scanInt(p, end, quantity) != NULL;
+}
+
+/**
+    Hashes a (member, item) pair for a worker's table.
+    @param memberIndex the position of the member in the member list
+    @param itemIndex the position of the item in the item list
+    @return the hash of the pair
+ */
+static unsigned int hashPair( int memberIndex, int itemIndex )
+{
+    unsigned long long key = (unsigned long long)(unsigned int) memberIndex << PAIR_HASH_SHIFT | (unsigned int) itemIndex;
+    return (unsigned int)((key * PAIR_HASH_MULTIPLIER) >> PAIR_HASH_SHIFT);
+}
+
+/**
+    Finds the slot for a (member, item) pair in a table of totals, using linear probing.
+    @param *totals the table
+    @param cap the number of slots in the table, a power of two
+    @param memberIndex the position of the member in the member list
+    @param itemIndex the position of the item in the item list
+    @return the slot holding the pair, or the empty slot where it belongs
+ */
+static int findPair( PairTotal const *totals, int cap, int memberIndex, int itemIndex )
+{
+    unsigned int mask = cap - 1;
+    unsigned int slot = hashPair(memberIndex, itemIndex) & mask;
+    while (totals[slot].memberIndex != NO_MEMBER &&
+           (totals[slot].memberIndex != memberIndex || totals[slot].itemIndex != itemIndex)) {
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+/**
+    Allocates a table of totals with every slot empty.
+    @param cap the number of slots, a power of two
+    @return the new table
+ */
+static PairTotal *makeTotals( int cap )
+{
+    PairTotal *totals = (PairTotal *)malloc(cap * sizeof(PairTotal));
+    if (totals == NULL) {
+        fprintf(stderr, "Memory allocation issue.\n");
+        exit(EXIT_FAILURE);
+    }
+    for (int i = 0; i < cap; i++) {
+        totals[i].memberIndex = NO_MEMBER;
+    }
+    return totals;
+}
+
+/**
+    Adds a sale to a worker's totals, doubling the table first if it would become more than half full.
+    @param *w the worker
+    @param memberIndex the position of the member in the member list
+    @param itemIndex the position of the item in the item list
+    @param quantity how many of the item were sold
+ */
+static void addTotal( Worker *w, int memberIndex, int itemIndex, int quantity )
+{
+    int slot = findPair(w -> totals, w -> totalCap, memberIndex, itemIndex);
+    if (w -> totals[slot].memberIndex == NO_MEMBER) {
+        if ((w -> totalCount + 1) * DOUBLE_SIZE > w -> totalCap) {
+            int newCap = w -> totalCap * DOUBLE_SIZE;
+            PairTotal *newTotals = makeTotals(newCap);
+            for (int i = 0; i < w -> totalCap; i++) {
+                if (w -> totals[i].memberIndex != NO_MEMBER) {
+                    newTotals[findPair(newTotals, newCap, w -> totals[i].memberIndex, w -> totals[i].itemIndex)] =
+                        w -> totals[i];
+                }
+            }
+            free(w -> totals);
+            w -> totals = newTotals;
+            w -> totalCap = newCap;
+            slot = findPair(w -> totals, w -> totalCap, memberIndex, itemIndex);
+        }
+        w -> totals[slot].memberIndex = memberIndex;
+        w -> totals[slot].itemIndex = itemIndex;
+        w -> totals[slot].quantity = 0;
+        w -> totalCount++;
+    }
+    w -> totals[slot].quantity += quantity;
+}
+
+/**
+    Remembers a line the sale command would reject, so it can be reported after the workers finish.
+    @param *w the worker
+    @param *line the start of the line
+ */
+static void addInvalid( Worker *w, char const *line )
+{
+    if (w -> invalidCount == w -> invalidCap) {
+        w -> invalidCap = w -> invalidCap == 0 ? INITIAL_SIZE : w -> invalidCap * DOUBLE_SIZE;
+        char const **newInvalid = realloc(w -> invalid, w -> invalidCap * sizeof(char const *));
+        if (newInvalid == NULL) {
+            fprintf(stderr, "Memory allocation issue.\n");
+            exit(EXIT_FAILURE);
+        }
+        w -> invalid = newInvalid;
+    }
+    w -> invalid[w -> invalidCount++] = line;
+}
+
+/**
+    Parses the lines of a worker's part of the file and totals up the valid sales. The group is only read.
+    @param *arg the worker
+    @return NULL
+ */
+static void *runWorker( void *arg )
+{
+    Worker *w = arg;
+    char const *p = w -> start;
+    while (p < w -> end) {
+        char const *eol = memchr(p, '\n', w -> end - p);
+        if (eol == NULL) {
+            eol = w -> end;
+        }
+        char memberId[MAX_ID_LEN + 1];
+        int itemId = 0, quantity = 0;
+        int memberIndex = -1;
+        if (parseSale(p, eol, memberId, &itemId, &quantity)) {
+            memberIndex = findMemberIndex(w -> group, memberId);
+        }
+        if (memberIndex < 0) {
+            addInvalid(w, p);
+        }
+        else {
+            // a sale of an unknown item by a known member is accepted and changes nothing
+            int itemIndex = findItemIndex(w -> group, itemId);
+            if (itemIndex >= 0) {
+                addTotal(w, memberIndex, itemIndex, quantity);
+                w -> applied++;
+            }
+        }
+        p = eol + 1;
+    }
+    return NULL;
+}
+
+/**
+    Reports a line the sale command would reject, with the same output the sale command gives for it.
+    @param *line the start of the line
+    @param *end the end of the file
+    @param *out the stream to report on
+ */
+static void reportInvalid( char const *line, char const *end, Output *out )
+{
+    char const *eol = memchr(line, '\n', end - line);
+    if (eol == NULL) {
+        eol = end;
+    }
+    char memberId[MAX_ID_LEN + 1];
+    int itemId = 0, quantity = 0;
+    if (parseSale(line, eol, memberId, &itemId, &quantity)) {
+        putFormat(out, "cmd> sale %s %d %d\n", memberId, itemId, quantity);
+    }
+    else {
+        putFormat(out, "cmd> %.*s\n", (int)(eol - line), line);
+    }
+    putFormat(out, "Invalid command\n\n");
+}
+
+/**
+    Decides how many workers to split a file of the given size between.
+    @param size the size of the file in bytes
+    @return the number of workers
+ */
+static int workerCount( size_t size )
+{
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    long n = (long)(size / MIN_CHUNK) + 1;
+    if (n > cpus) {
+        n = cpus;
+    }
+    if (n > MAX_WORKERS) {
+        n = MAX_WORKERS;
+    }
+    return n < 1 ? 1 : (int) n;
+}
+
+/**
+    Applies every "sale <memberId> <itemId> <quantity>" line of a sales file to the group. The file is split into
+    chunks that worker threads parse and total up by member and item, and the totals are then recorded with
+    recordSale, which leaves the group just as if each sale had been entered as a command. Lines the sale command
+    would reject are reported in file order, the way the sale command reports them.
+    @param *group the group to record the sales in
+    @param *filename the name of the sales file
+    @param *out the output to report invalid lines on
+    @return the number of sales applied, or -1 if the file couldn't be opened
+ */
+long long loadSales( Group *group, char const *filename, Output *out )
+{
+    MappedFile file;
+    if (!mapFile(filename, &file)) {
+        return -1;
+    }
+    char const *end = file.data + file.size;
+    int n = workerCount(file.size);
+    Worker workers[MAX_WORKERS];
+    pthread_t threads[MAX_WORKERS];
+
+    // split the file into chunks that each start at the beginning of a line
+    char const *p = file.data;
+    for (int i = 0; i < n; i++) {
+        Worker *w = &workers[i];
+        w -> group = group;
+        w -> start = p;
+        char const *cut = i == n - 1 ? end : file.data + file.size / n * (i + 1);
+        if (cut < p) {
+            cut = p;
+        }
+        char const *nl = cut < end ? memchr(cut, '\n', end - cut) : NULL;
+        w -> end = nl == NULL || i == n - 1 ? end : nl + 1;
+        p = w -> end;
+        w -> totals = makeTotals(INITIAL_TOTALS);
+        w -> totalCount = 0;
+        w -> totalCap = INITIAL_TOTALS;
+        w -> invalid = NULL;
+        w -> invalidCount = 0;
+        w -> invalidCap = 0;
+        w -> applied = 0;
+    }
+
+    for (int i = 1; i < n; i++) {
+        if (pthread_create(&threads[i], NULL, runWorker, &workers[i]) != 0) {
+            fprintf(stderr, "Can't start a worker thread.\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+    runWorker(&workers[0]);
+    for (int i = 1; i < n; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    // the chunks are in file order, so this reports the invalid lines in file order
+    for (int i = 0; i < n; i++) {
+        for (int j = 0; j < workers[i].invalidCount; j++) {
+            reportInvalid(workers[i].invalid[j], end, out);
+        }
+    }
+    long long applied = 0;
+    for (int i = 0; i < n; i++) {
+        Worker *w = &workers[i];
+        applied += w -> applied;
+        for (int j = 0; j < w -> totalCap; j++) {
+            if (w -> totals[j].memberIndex != NO_MEMBER) {
+                recordSale(group, group -> mList[w -> totals[j].memberIndex], w -> totals[j].itemIndex,
+                           (int) w -> totals[j].quantity);
+            }
+        }
+        free(w -> totals);
+        free(w -> invalid);
+    }
+    unmapFile(&file);
+    return applied;
+}
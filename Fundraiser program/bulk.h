@@ -0,0 +1,29 @@
+/**
+    @file bulk.h
+    @author Sachi Vyas (smvyas)
+    A program that: The prototype for bulk.c
+ */
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+
+#ifndef BULK_H
+#define BULK_H
+
+#include "output.h"
+
+struct GroupStruct;
+
+/**
+    Applies every "sale <memberId> <itemId> <quantity>" line of a sales file to the group. The file is split into
+    chunks that worker threads parse and total up by member and item, and the totals are then recorded with
+    recordSale, which leaves the group just as if each sale had been entered as a command. Lines the sale command
+    would reject are reported in file order, the way the sale command reports them.
+    @param *group the group to record the sales in
+    @param *filename the name of the sales file
+    @param *out the output to report invalid lines on
+    @return the number of sales applied, or -1 if the file couldn't be opened
+ */
+long long loadSales( struct GroupStruct *group, char const *filename, Output *out );
+
+#endif
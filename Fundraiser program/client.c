@@ -0,0 +1,143 @@
+/**
+    @file client.c
+    @author Sachi Vyas (smvyas)
+    A program that: Connects to a fundraiser server on a Unix domain socket, sends it the commands on
+    standard input and copies its replies to standard output, so the server can be tested without nc or
+    socat. Commands are sent while replies are read, so a long input can't fill both ways at once, and a
+    server that is still starting is given a few seconds to listen.
+ */
+#define _POSIX_C_SOURCE 200809L
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <poll.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+/** Number of command line arguments needed, counting the program name */
+#define MIN_ARGS 2
+/** Size of the buffers copied through in each direction */
+#define BUFFER_SIZE 65536
+/** Number of times to try connecting while the server is still starting */
+#define CONNECT_TRIES 50
+/** Nanoseconds to wait between tries */
+#define CONNECT_WAIT_NS 100000000
+
+/**
+    Writes all of a run of bytes to a file descriptor, continuing after short writes and interruptions.
+    @param fd the file descriptor
+    @param *data the bytes
+    @param size the number of bytes
+    @return false if the file descriptor can't be written
+ */
+static bool writeAll( int fd, char const *data, size_t size )
+{
+    while (size > 0) {
+        ssize_t n = write(fd, data, size);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n < 0) {
+            return false;
+        }
+        data += n;
+        size -= n;
+    }
+    return true;
+}
+
+/**
+    Connects to the server, trying again for a while if its socket isn't there or isn't listening yet.
+    @param *addr the address of the socket
+    @return the connected socket, or -1 if the server never answered
+ */
+static int connectServer( struct sockaddr_un const *addr )
+{
+    struct timespec wait = { 0, CONNECT_WAIT_NS };
+    for (int i = 0; i < CONNECT_TRIES; i++) {
+        int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd < 0) {
+            return -1;
+        }
+        if (connect(fd, (struct sockaddr const *)addr, sizeof(*addr)) == 0) {
+            return fd;
+        }
+        bool starting = errno == ENOENT || errno == ECONNREFUSED;
+        close(fd);
+        if (!starting) {
+            return -1;
+        }
+        nanosleep(&wait, NULL);
+    }
+    return -1;
+}
+
+/**
+    Sends standard input to the server and copies its replies to standard output until the server is done.
+    @param argc the number of arguments in the command line
+    @param argv the program name and the path of the socket
+    @return 0 if every reply was copied, 1 otherwise
+ */
+int main( int argc, char *argv[] )
+{
+    struct sockaddr_un addr;
+    if (argc != MIN_ARGS || strlen(argv[1]) >= sizeof(addr.sun_path)) {
+        fprintf(stderr, "usage: client socket-path\n");
+        exit(EXIT_FAILURE);
+    }
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, argv[1]);
+    int fd = connectServer(&addr);
+    if (fd < 0) {
+        fprintf(stderr, "Can't connect to socket: %s\n", argv[1]);
+        exit(EXIT_FAILURE);
+    }
+
+    static char buffer[BUFFER_SIZE];
+    struct pollfd fds[MIN_ARGS];
+    fds[0].fd = fd;
+    fds[0].events = POLLIN;
+    fds[1].fd = STDIN_FILENO;
+    fds[1].events = POLLIN;
+    bool sending = true;
+    while (true) {
+        if (poll(fds, sending ? MIN_ARGS : 1, -1) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+        if (sending && fds[1].revents != 0) {
+            ssize_t len = read(STDIN_FILENO, buffer, sizeof(buffer));
+            if (len > 0 && !writeAll(fd, buffer, len)) {
+                break;
+            }
+            if (len == 0 || (len < 0 && errno != EINTR)) {
+                // the server sees the end of the commands the way the program sees the end of standard input
+                shutdown(fd, SHUT_WR);
+                sending = false;
+            }
+        }
+        if (fds[0].revents != 0) {
+            ssize_t len = read(fd, buffer, sizeof(buffer));
+            if (len == 0) {
+                close(fd);
+                return EXIT_SUCCESS;
+            }
+            if (len < 0 && errno != EINTR) {
+                break;
+            }
+            if (len > 0 && !writeAll(STDOUT_FILENO, buffer, len)) {
+                break;
+            }
+        }
+    }
+    fprintf(stderr, "Lost the connection to socket: %s\n", argv[1]);
+    close(fd);
+    return EXIT_FAILURE;
+}
@@ -0,0 +1,54 @@
+/**
+    @file column.c
+    @author Sachi Vyas (smvyas)
+    A program that: Adds up the columns of numbers the items are kept in, sixteen bytes at a time where the
+    processor allows it.
+ */
+#include "column.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+/** Numbers in one vector register */
+#define LANES 2
+/** Vector registers added into at once, so the additions don't wait on each other */
+#define ACCUMULATORS 4
+/** Numbers summed by one step of the vector loop */
+#define STEP (LANES * ACCUMULATORS)
+
+/**
+    Adds up a column of numbers, two at a time in each of several vector registers where the processor
+    allows it, so a whole column is summed about as fast as it can be read from memory.
+    @param *column the numbers
+    @param count how many there are
+    @return the sum
+ */
+long long sumColumn( long long const *column, int count )
+{
+    // the sum wraps like unsigned numbers, which gives the same result whichever order it is added in
+    unsigned long long sum = 0;
+    int i = 0;
+#ifdef __SSE2__
+    __m128i a0 = _mm_setzero_si128();
+    __m128i a1 = _mm_setzero_si128();
+    __m128i a2 = _mm_setzero_si128();
+    __m128i a3 = _mm_setzero_si128();
+    for (; i + STEP <= count; i += STEP) {
+        a0 = _mm_add_epi64(a0, _mm_loadu_si128((__m128i const *)(column + i)));
+        a1 = _mm_add_epi64(a1, _mm_loadu_si128((__m128i const *)(column + i + LANES)));
+        a2 = _mm_add_epi64(a2, _mm_loadu_si128((__m128i const *)(column + i + 2 * LANES)));
+        a3 = _mm_add_epi64(a3, _mm_loadu_si128((__m128i const *)(column + i + 3 * LANES)));
+    }
+    __m128i total = _mm_add_epi64(_mm_add_epi64(a0, a1), _mm_add_epi64(a2, a3));
+    unsigned long long lanes[LANES];
+    _mm_storeu_si128((__m128i *) lanes, total);
+    sum = lanes[0] + lanes[1];
+#endif
+    for (; i < count; i++) {
+        sum += (unsigned long long) column[i];
+    }
+    return (long long) sum;
+}
@@ -0,0 +1,22 @@
+/**
+    @file column.h
+    @author Sachi Vyas (smvyas)
+    A program that: The prototype for column.c
+ */
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+
+#ifndef COLUMN_H
+#define COLUMN_H
+
+/**
+    Adds up a column of numbers, two at a time in each of several vector registers where the processor
+    allows it, so a whole column is summed about as fast as it can be read from memory.
+    @param *column the numbers
+    @param count how many there are
+    @return the sum
+ */
+long long sumColumn( long long const *column, int count );
+
+#endif
@@ -0,0 +1,825 @@
+/**
+    @file command.c
+    @author Sachi Vyas (smvyas)
+    A program that: Runs the commands of the fundraiser protocol against a group, for standard input or for
+    a client of the server alike.
+ */
+#include "input.h"
+#include "group.h"
+#include "bulk.h"
+#include "stats.h"
+#include "snapshot.h"
+#include "reload.h"
+#include "command.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+
+/** Number of fields in a sale command */
+#define SALE_FIELDS 3
+/** Most words of a command that are kept; no command has this many, so one with more is never valid */
+#define MAX_TOKENS 12
+/** Longest text a search member command searches for */
+#define SEARCH_MEMBER_LEN 15
+
+/** Struct for one word of a command, which points into the command instead of being copied out of it */
+struct TokenStruct {
+    char const *start;
+    int len;
+};
+typedef struct TokenStruct Token;
+
+/**
+    Struct for a command split into its words in one pass. The words after the ones that name the command
+    are its arguments, and the page of a list or search command, if it has one, is taken off their end.
+ */
+struct CommandStruct {
+    char const *line;
+    char const *end;
+    Token tokens[MAX_TOKENS];
+    int count;
+    int args;
+    Page page;
+    char const *pageWords;
+    int pageLen;
+};
+typedef struct CommandStruct Command;
+
+/**
+    Struct for a command of the protocol: the words that name it after its first one, the function that runs
+    it, what it is counted as in the statistics, whether it may end with a page and whether it only reads the
+    group. The function returns false, having added no output, if the arguments don't fit the command, and
+    the command is then echoed as an invalid one.
+ */
+struct CommandSpecStruct {
+    char const *words;
+    bool (*run)( Session *session, Command const *command, Output *out );
+    enum CommandKind kind;
+    bool paged;
+    bool readOnly;
+};
+typedef struct CommandSpecStruct CommandSpec;
+
+/**
+    Struct for the first word of commands of the protocol, and the commands it starts, which end with one
+    that has no run function. A command is found by its first word and then by the rest of its words, so no
+    word is compared twice.
+ */
+struct VerbStruct {
+    char const *word;
+    CommandSpec const *commands;
+};
+typedef struct VerbStruct Verb;
+
+/**
+    Checks if a string is contained in the name of an item
+    @param *name the name of the item that we are currently looking at
+    @param *str a pointer to a str to compare
+    @return true if *str is equal to the name else returns false
+ */
+bool testItemNameEquals(char const *name, char const *str) {
+    if (str == NULL || *str == '\0') {
+        return true;
+    }
+    return strstr(name, str) != NULL;
+}
+/**
+    Checks if a string is contained in the member pointer
+    @param *member a pointer to a member that we are currently looking at
+    @param *str a pointer to a str to compare
+    @return true if *str is equal to the name else returns false
+ */
+bool testMemberNameEquals(Member const *member, char const *str) {
+    if (str == NULL || *str == '\0') {
+        return true;
+    }
+    return strstr(member -> name, str) != NULL;
+}
+/**
+    Initializes a session for running commands against a group.
+    @param *session the session to initialize
+    @param *group the group the commands work on
+    @param *stats the statistics to time the commands in, or NULL when built with NO_STATS
+ */
+void initSession( Session *session, Group *group, Stats *stats )
+{
+    session -> group = group;
+    session -> stats = stats;
+    memset(session -> memberId, 0, sizeof(session -> memberId));
+    session -> itemId = 0;
+    session -> numItemsSold = 0;
+}
+
+/**
+    Splits a command into its words, at the characters sscanf counts as white space, without copying them.
+    @param *line the command
+    @param *command set to the words of the command, all of them counted but only the first MAX_TOKENS kept
+ */
+static void splitWords( char const *line, Command *command )
+{
+    command -> line = line;
+    command -> count = 0;
+    char const *p = line;
+    while (true) {
+        while (*p == ' ' || isBlank(*p)) {
+            p++;
+        }
+        if (*p == '\0') {
+            break;
+        }
+        // every character above the blank is part of a word, so only control characters need isBlank
+        char const *start = p;
+        while ((unsigned char) *p > ' ' || (*p != '\0' && !isBlank(*p))) {
+            p++;
+        }
+        if (command -> count < MAX_TOKENS) {
+            command -> tokens[command -> count].start = start;
+            command -> tokens[command -> count].len = (int) (p - start);
+        }
+        command -> count++;
+    }
+    command -> end = p;
+}
+
+/**
+    Checks if a word of a command is the given word.
+    @param *token the word of the command
+    @param *word the word to compare it with
+    @return true if they are the same
+ */
+static bool isWord( Token const *token, char const *word )
+{
+    for (int i = 0; i < token -> len; i++) {
+        if (token -> start[i] != word[i]) {
+            return false;
+        }
+    }
+    return word[token -> len] == '\0';
+}
+
+/**
+    Reads a word of a command that is a count, with scanInt.
+    @param *token the word of the command
+    @param *value set to the number
+    @return true if the word is a number that isn't below zero, with nothing else in it
+ */
+static bool readCount( Token const *token, int *value )
+{
+    char const *end = token -> start + token -> len;
+    return scanInt(token -> start, end, value) == end && *value >= 0;
+}
+
+/**
+    Copies a word of a command into a string, cut short if it is too long the way %Ns cuts it.
+    @param *dest the string, with room for max characters and the null terminator
+    @param *token the word of the command
+    @param max the most characters to copy
+ */
+static void copyWord( char *dest, Token const *token, int max )
+{
+    int len = token -> len < max ? token -> len : max;
+    memcpy(dest, token -> start, len);
+    dest[len] = '\0';
+}
+
+/**
+    Counts the arguments of a command, the words after the ones that name it and before its page.
+    @param *command the command
+    @return the number of arguments
+ */
+static int argCount( Command const *command )
+{
+    return command -> count - command -> args;
+}
+
+/**
+    Takes a page of the form "limit N" or "limit N offset M" off the end of a list or search command.
+    @param *command the command, whose page is set and whose words stop before the page if it has one
+ */
+static void takePage( Command *command )
+{
+    int last = command -> count;
+    if (last > MAX_TOKENS) {
+        return;
+    }
+    Token const *tokens = command -> tokens;
+    int limit = 0;
+    int offset = 0;
+    int first = last;
+    if (last - command -> args >= 4 && isWord(&tokens[last - 4], "limit") && readCount(&tokens[last - 3], &limit) &&
+        isWord(&tokens[last - 2], "offset") && readCount(&tokens[last - 1], &offset)) {
+        first = last - 4;
+    }
+    else if (last - command -> args >= 2 && isWord(&tokens[last - 2], "limit") &&
+             readCount(&tokens[last - 1], &limit)) {
+        first = last - 2;
+        offset = 0;
+    }
+    else {
+        return;
+    }
+    command -> page.offset = offset;
+    command -> page.limit = limit;
+    command -> pageWords = tokens[first].start;
+    command -> pageLen = (int) (tokens[last - 1].start + tokens[last - 1].len - tokens[first].start);
+    command -> count = first;
+}
+
+/**
+    Ends the echo of a command with the page it was given, if it had one, and a newline.
+    @param *out the output to add to
+    @param *command the command
+ */
+static void putPage( Output *out, Command const *command )
+{
+    if (command -> pageWords != NULL) {
+        putFormat(out, " %.*s", command -> pageLen, command -> pageWords);
+    }
+    putChar(out, '\n');
+}
+
+/**
+    Runs a quit command.
+    @param *session the session the command belongs to
+    @param *command the command
+    @param *out the output to add to
+    @return true, as anything after the word quit is left out
+ */
+static bool runQuit( Session *session, Command const *command, Output *out )
+{
+    putFormat(out, "cmd> quit\n");
+    return true;
+}
+
+/**
+    Runs a sale command. The fields are read the way "sale %8s %d %d" reads them, into the session, so one
+    that can't be read echoes what the last sale read after the fields it did read.
+    @param *session the session the command belongs to
+    @param *command the command
+    @param *out the output to add to
+    @return true, as a sale that can't be read has its own echo
+ */
+static bool runSale( Session *session, Command const *command, Output *out )
+{
+    int fields = 0;
+    if (argCount(command) > 0) {
+        Token const *id = &command -> tokens[command -> args];
+        copyWord(session -> memberId, id, SESSION_ID_LEN);
+        fields++;
+        char const *p = id -> start + strlen(session -> memberId);
+        p = scanInt(p, command -> end, &session -> itemId);
+        if (p != NULL) {
+            fields++;
+            if (scanInt(p, command -> end, &session -> numItemsSold) != NULL) {
+                fields++;
+            }
+        }
+    }
+    putFormat(out, "cmd> sale %s %d %d\n", session -> memberId, session -> itemId, session -> numItemsSold);
+    if (fields < SALE_FIELDS) {
+        putFormat(out, "Invalid command\n");
+        STATS_INVALID(session -> stats);
+        return true;
+    }
+    int state = sellItem(session -> group, session -> memberId, session -> itemId, session -> numItemsSold);
+    if (state == SALE_RECORDED) {
+        STATS_SALES(session -> stats, 1);
+    }
+    if (state == SALE_INVALID) {
+        putFormat(out, "Invalid command\n\n");
+        STATS_INVALID(session -> stats);
+    }
+    else {
+        putChar(out, '\n');
+    }
+    return true;
+}
+
+/**
+    Runs a load sales command, whose file name is the rest of the command.
+    @param *session the session the command belongs to
+    @param *command the command
+    @param *out the output to add to
+    @return false if the command has no file name
+ */
+static bool runLoadSales( Session *session, Command const *command, Output *out )
+{
+    if (argCount(command) == 0) {
+        return false;
+    }
+    putFormat(out, "cmd> %s\n", command -> line);
+    long long applied = loadSales(session -> group, command -> tokens[command -> args].start, out);
+    if (applied < 0) {
+        putFormat(out, "Invalid command\n");
+        STATS_INVALID(session -> stats);
+    }
+    else {
+        STATS_SALES(session -> stats, applied);
+    }
+    putFormat(out, "\n");
+    return true;
+}
+
+/**
+    Runs a save snapshot command, whose file name is the rest of the command.
+    @param *session the session the command belongs to
+    @param *command the command
+    @param *out the output to add to
+    @return false if the command has no file name
+ */
+static bool runSaveSnapshot( Session *session, Command const *command, Output *out )
+{
+    if (argCount(command) == 0) {
+        return false;
+    }
+    putFormat(out, "cmd> %s\n", command -> line);
+    if (!saveSnapshot(session -> group, command -> tokens[command -> args].start)) {
+        putFormat(out, "Invalid command\n");
+        STATS_INVALID(session -> stats);
+    }
+    putFormat(out, "\n");
+    return true;
+}
+
+/**
+    Reads the file of a reload items or reload members command, whose file name is the rest of the command.
+    @param *command the command
+    @return the file read for the reload, or NULL if the command has no file name or it couldn't be read
+ */
+static Reload *readReload( Command const *command )
+{
+    if (argCount(command) == 0) {
+        return NULL;
+    }
+    return prepareReload(isWord(&command -> tokens[1], "members"), command -> tokens[command -> args].start);
+}
+
+/**
+    Swaps the file of a reload command into the session's group and adds the command's output.
+    @param *session the session the command belongs to
+    @param *cmd the command
+    @param *reload the file from readReloadFile, or NULL if it couldn't be read
+    @param *out the output to add to
+ */
+static void reloadGroup( Session *session, char const *cmd, Reload *reload, Output *out )
+{
+    putFormat(out, "cmd> %s\n", cmd);
+    if (reload == NULL || !applyReload(session -> group, reload)) {
+        putFormat(out, "Invalid command\n");
+        STATS_INVALID(session -> stats);
+    }
+    putFormat(out, "\n");
+}
+
+/**
+    Runs a reload items or reload members command, reading its file on this thread.
+    @param *session the session the command belongs to
+    @param *command the command
+    @param *out the output to add to
+    @return false if the command has no file name
+ */
+static bool runReload( Session *session, Command const *command, Output *out )
+{
+    if (argCount(command) == 0) {
+        return false;
+    }
+    reloadGroup(session, command -> line, readReload(command), out);
+    return true;
+}
+
+/**
+    Runs a list items command.
+    @param *session the session the command belongs to
+    @param *command the command
+    @param *out the output to add to
+    @return false if the command has arguments
+ */
+static bool runListItems( Session *session, Command const *command, Output *out )
+{
+    if (argCount(command) != 0) {
+        return false;
+    }
+    putFormat(out, "cmd> list items");
+    putPage(out, command);
+    putFormat(out, "%-3s %-30s %6s %6s %6s\n", "ID", "Name", "Cost", "Sold", "Total");
+    listItems(session -> group, NULL, NULL, NULL, &command -> page, out);
+    return true;
+}
+
+/**
+    Runs a list item names command.
+    @param *session the session the command belongs to
+    @param *command the command
+    @param *out the output to add to
+    @return false if the command has arguments
+ */
+static bool runListItemNames( Session *session, Command const *command, Output *out )
+{
+    if (argCount(command) != 0) {
+        return false;
+    }
+    putFormat(out, "cmd> list item names");
+    putPage(out, command);
+    putFormat(out, "%-3s %-30s %6s %6s %6s\n", "ID", "Name", "Cost", "Sold", "Total");
+    listItems(session -> group, session -> group -> itemsByName, NULL, NULL, &command -> page, out);
+    return true;
+}
+
+/**
+    Runs a list members command.
+    @param *session the session the command belongs to
+    @param *command the command
+    @param *out the output to add to
+    @return false if the command has arguments
+ */
+static bool runListMembers( Session *session, Command const *command, Output *out )
+{
+    if (argCount(command) != 0) {
+        return false;
+    }
+    putFormat(out, "cmd> list members");
+    putPage(out, command);
+    putFormat(out, "%-8s %-30s %6s %6s\n", "ID", "Name", "Sold", "Total");
+    listMembers(session -> group, NULL, NULL, NULL, &command -> page, out);
+    return true;
+}
+
+/**
+    Runs a list member names command.
+    @param *session the session the command belongs to
+    @param *command the command
+    @param *out the output to add to
+    @return false if the command has arguments
+ */
+static bool runListMemberNames( Session *session, Command const *command, Output *out )
+{
+    if (argCount(command) != 0) {
+        return false;
+    }
+    putFormat(out, "cmd> list member names");
+    putPage(out, command);
+    putFormat(out, "%-8s %-30s %6s %6s\n", "ID", "Name", "Sold", "Total");
+    listMembers(session -> group, session -> group -> membersByName, NULL, NULL, &command -> page, out);
+    return true;
+}
+
+/**
+    Runs a list topsellers command, with or without the number of sellers to list.
+    @param *session the session the command belongs to
+    @param *command the command
+    @param *out the output to add to
+    @return false if the command has more than one argument, or one that isn't a number
+ */
+static bool runListTopSellers( Session *session, Command const *command, Output *out )
+{
+    int topCount = -1;
+    if (argCount(command) > 1 || (argCount(command) == 1 && !readCount(&command -> tokens[command -> args],
+                                                                         &topCount))) {
+        return false;
+    }
+    putFormat(out, "cmd> list topsellers");
+    if (topCount >= 0) {
+        putFormat(out, " %d", topCount);
+    }
+    putPage(out, command);
+    putFormat(out, "%-8s %-30s %6s %6s\n", "ID", "Name", "Sold", "Total");
+    listTopSellers(session -> group, topCount, &command -> page, out);
+    return true;
+}
+
+/**
+    Runs a list member command. Any words after the member's id are left out.
+    @param *session the session the command belongs to
+    @param *command the command
+    @param *out the output to add to
+    @return false if the command has no member id or no member has it
+ */
+static bool runListMember( Session *session, Command const *command, Output *out )
+{
+    // no member has an id too long for the buffer
+    if (argCount(command) == 0 || command -> tokens[command -> args].len > MAX_ID_LEN) {
+        return false;
+    }
+    char memberId[MAX_ID_LEN + 1];
+    copyWord(memberId, &command -> tokens[command -> args], MAX_ID_LEN);
+    Member *m = findMember(session -> group, memberId);
+    if (m == NULL) {
+        return false;
+    }
+    putFormat(out, "cmd> list member %s", memberId);
+    putPage(out, command);
+    putFormat(out, "%-3s %-30s %6s %6s %6s\n", "ID", "Name", "Cost", "Sold", "Total");
+    listMemberSales(session -> group, m, &command -> page, out);
+    return true;
+}
+
+/**
+    Runs a search ignorecase item command. Any words after the first one searched for are left out.
+    @param *session the session the command belongs to
+    @param *command the command
+    @param *out the output to add to
+    @return false if the command has nothing to search for
+ */
+static bool runSearchIgnoreCaseItem( Session *session, Command const *command, Output *out )
+{
+    if (argCount(command) == 0) {
+        return false;
+    }
+    char searchStr[MAX_NAME_LEN + 1];
+    copyWord(searchStr, &command -> tokens[command -> args], MAX_NAME_LEN);
+    putFormat(out, "cmd> %s\n", command -> line);
+    putFormat(out, "%-3s %-30s %6s %6s %6s\n", "ID", "Name", "Cost", "Sold", "Total");
+    searchItemsIgnoreCase(session -> group, searchStr, &command -> page, out);
+    return true;
+}
+
+/**
+    Runs a search ignorecase member command. Any words after the first one searched for are left out.
+    @param *session the session the command belongs to
+    @param *command the command
+    @param *out the output to add to
+    @return false if the command has nothing to search for
+ */
+static bool runSearchIgnoreCaseMember( Session *session, Command const *command, Output *out )
+{
+    if (argCount(command) == 0) {
+        return false;
+    }
+    char searchStr[MAX_NAME_LEN + 1];
+    copyWord(searchStr, &command -> tokens[command -> args], MAX_NAME_LEN);
+    putFormat(out, "cmd> %s\n", command -> line);
+    putFormat(out, "%-8s %-30s %6s %6s\n", "ID", "Name", "Sold", "Total");
+    searchMembersIgnoreCase(session -> group, searchStr, &command -> page, out);
+    return true;
+}
+
+/**
+    Runs a search item command. Any words after the first one searched for are left out.
+    @param *session the session the command belongs to
+    @param *command the command
+    @param *out the output to add to
+    @return false if the command has nothing to search for
+ */
+static bool runSearchItem( Session *session, Command const *command, Output *out )
+{
+    if (argCount(command) == 0) {
+        return false;
+    }
+    char searchStr[MAX_NAME_LEN + 1];
+    copyWord(searchStr, &command -> tokens[command -> args], MAX_NAME_LEN);
+    putFormat(out, "cmd> %s\n", command -> line);
+    putFormat(out, "%-3s %-30s %6s %6s %6s\n", "ID", "Name", "Cost", "Sold", "Total");
+    searchItems(session -> group, testItemNameEquals, searchStr, &command -> page, out);
+    return true;
+}
+
+/**
+    Runs a search member command. Any words after the first one searched for are left out.
+    @param *session the session the command belongs to
+    @param *command the command
+    @param *out the output to add to
+    @return false if the command has nothing to search for
+ */
+static bool runSearchMember( Session *session, Command const *command, Output *out )
+{
+    if (argCount(command) == 0) {
+        return false;
+    }
+    char searchStr[SEARCH_MEMBER_LEN + 1];
+    copyWord(searchStr, &command -> tokens[command -> args], SEARCH_MEMBER_LEN);
+    putFormat(out, "cmd> search member %s", searchStr);
+    putPage(out, command);
+    putFormat(out, "%-8s %-30s %6s %6s\n", "ID", "Name", "Sold", "Total");
+    searchMembers(session -> group, testMemberNameEquals, searchStr, &command -> page, out);
+    return true;
+}
+
+#ifndef NO_STATS
+/**
+    Runs a stats command.
+    @param *session the session the command belongs to
+    @param *command the command
+    @param *out the output to add to
+    @return false if the command has arguments
+ */
+static bool runStats( Session *session, Command const *command, Output *out )
+{
+    if (argCount(command) != 0) {
+        return false;
+    }
+    putFormat(out, "cmd> stats\n");
+    printStats(session -> stats, outputBytes(out), out);
+    return true;
+}
+#endif
+
+/** The commands that start with each word, each one after any command whose words start it */
+static CommandSpec const quitCommands[] = {
+    { "", runQuit, CMD_QUIT, false, false },
+    { NULL }
+};
+static CommandSpec const saleCommands[] = {
+    { "", runSale, CMD_SALE, false, false },
+    { NULL }
+};
+static CommandSpec const loadCommands[] = {
+    { "sales", runLoadSales, CMD_LOAD_SALES, false, false },
+    { NULL }
+};
+static CommandSpec const saveCommands[] = {
+    { "snapshot", runSaveSnapshot, CMD_SAVE_SNAPSHOT, false, false },
+    { NULL }
+};
+static CommandSpec const reloadCommands[] = {
+    { "items", runReload, CMD_RELOAD, false, false },
+    { "members", runReload, CMD_RELOAD, false, false },
+    { NULL }
+};
+static CommandSpec const listCommands[] = {
+    { "items", runListItems, CMD_LIST_ITEMS, true, true },
+    { "item names", runListItemNames, CMD_LIST_ITEM_NAMES, true, true },
+    { "members", runListMembers, CMD_LIST_MEMBERS, true, true },
+    { "member names", runListMemberNames, CMD_LIST_MEMBER_NAMES, true, true },
+    { "topsellers", runListTopSellers, CMD_LIST_TOPSELLERS, true, true },
+    // a member's sales are only kept up to date in the group itself
+    { "member", runListMember, CMD_LIST_MEMBER, true, false },
+    { NULL }
+};
+static CommandSpec const searchCommands[] = {
+    { "ignorecase item", runSearchIgnoreCaseItem, CMD_SEARCH_IGNORECASE_ITEM, true, true },
+    { "ignorecase member", runSearchIgnoreCaseMember, CMD_SEARCH_IGNORECASE_MEMBER, true, true },
+    { "item", runSearchItem, CMD_SEARCH_ITEM, true, true },
+    { "member", runSearchMember, CMD_SEARCH_MEMBER, true, true },
+    { NULL }
+};
+#ifndef NO_STATS
+static CommandSpec const statsCommands[] = {
+    { "", runStats, CMD_STATS, false, false },
+    { NULL }
+};
+#endif
+
+/**
+    The first words of the commands of the protocol. A new command only needs its run function and a line
+    in the commands for its first word.
+ */
+static Verb const verbs[] = {
+    { "quit", quitCommands },
+    { "sale", saleCommands },
+    { "load", loadCommands },
+    { "save", saveCommands },
+    { "reload", reloadCommands },
+    { "list", listCommands },
+    { "search", searchCommands },
+#ifndef NO_STATS
+    { "stats", statsCommands },
+#endif
+};
+
+/**
+    Counts the words of a command that match the words naming a command of the protocol.
+    @param *words the words naming the command of the protocol after its first one, with one blank between each
+    @param *command the command, whose first word has been matched
+    @return the number of words, the first one included, or 0 if the command doesn't start with all of them
+ */
+static int matchWords( char const *words, Command const *command )
+{
+    int count = 1;
+    while (*words != '\0') {
+        if (count == command -> count || count == MAX_TOKENS) {
+            return 0;
+        }
+        Token const *token = &command -> tokens[count];
+        for (int i = 0; i < token -> len; i++) {
+            if (words[i] != token -> start[i]) {
+                return 0;
+            }
+        }
+        words += token -> len;
+        if (*words == ' ') {
+            words++;
+        }
+        else if (*words != '\0') {
+            return 0;
+        }
+        count++;
+    }
+    return count;
+}
+
+/**
+    Splits a command into its words and finds the command of the protocol it is, with its page if it may
+    have one.
+    @param *line the command
+    @param *command set to the words of the command, its arguments and its page
+    @return the command of the protocol, or NULL if there is none
+ */
+static CommandSpec const *readCommand( char const *line, Command *command )
+{
+    splitWords(line, command);
+    command -> args = 0;
+    command -> page.offset = 0;
+    command -> page.limit = ALL_ROWS;
+    command -> pageWords = NULL;
+    command -> pageLen = 0;
+    if (command -> count == 0) {
+        return NULL;
+    }
+    for (size_t i = 0; i < sizeof(verbs) / sizeof(verbs[0]); i++) {
+        if (!isWord(&command -> tokens[0], verbs[i].word)) {
+            continue;
+        }
+        for (CommandSpec const *spec = verbs[i].commands; spec -> run != NULL; spec++) {
+            int words = matchWords(spec -> words, command);
+            if (words > 0) {
+                command -> args = words;
+                if (spec -> paged) {
+                    takePage(command);
+                }
+                return spec;
+            }
+        }
+        return NULL;
+    }
+    return NULL;
+}
+
+/**
+    Checks if a command reloads the item or member file, so its file can be read by another thread.
+    @param *cmd the command
+    @return true if the command is a reload items or reload members command
+ */
+bool isReload( char const *cmd )
+{
+    Command command;
+    CommandSpec const *spec = readCommand(cmd, &command);
+    return spec != NULL && spec -> kind == CMD_RELOAD;
+}
+
+/**
+    Reads the file of a reload command with prepareReload. No group is touched, so this can run on any thread.
+    @param *cmd the command, for which isReload is true
+    @return the file read for the reload, or NULL if it couldn't be opened or isn't valid
+ */
+Reload *readReloadFile( char const *cmd )
+{
+    Command command;
+    readCommand(cmd, &command);
+    return readReload(&command);
+}
+
+/**
+    Finishes a reload command whose file was read by readReloadFile, perhaps on another thread: the file is
+    swapped into the session's group and the command's output is added. Only the time of the swap is counted.
+    @param *session the session the command belongs to
+    @param *cmd the command
+    @param *reload the file from readReloadFile, or NULL if it couldn't be read
+    @param *out the output to add to
+ */
+void finishReload( Session *session, char const *cmd, Reload *reload, Output *out )
+{
+    STATS_START(start);
+    reloadGroup(session, cmd, reload, out);
+    STATS_RECORD(session -> stats, CMD_RELOAD, start);
+}
+
+/**
+    Runs one command and adds its output, echo included, to an output. The command is split into words once
+    and looked up in the table of commands, whose run function reads the arguments. A list or search command
+    may end with "limit N" or "limit N offset M" to print only some of its rows.
+    @param *session the session the command belongs to
+    @param *cmd the command
+    @param *out the output to add to
+    @return true if the command was quit, which ends the session
+ */
+bool runCommand( Session *session, char const *cmd, Output *out )
+{
+    STATS_START(start);
+    Command command;
+    CommandSpec const *spec = readCommand(cmd, &command);
+    enum CommandKind kind = CMD_INVALID;
+    if (spec != NULL && spec -> run(session, &command, out)) {
+        kind = spec -> kind;
+    }
+    else {
+        putFormat(out, "cmd> %s\n", cmd);
+        putFormat(out, "Invalid command\n\n");
+        STATS_INVALID(session -> stats);
+    }
+    STATS_RECORD(session -> stats, kind, start);
+    return kind == CMD_QUIT;
+}
+
+/**
+    Checks if a command only reads the group, so it can be run on a view of the group by another thread.
+    The command is matched the way runCommand matches it, page and all.
+    @param *cmd the command
+    @return true if runCommand would list or search with it and change nothing
+ */
+bool isReadOnly( char const *cmd )
+{
+    Command command;
+    CommandSpec const *spec = readCommand(cmd, &command);
+    return spec != NULL && spec -> readOnly;
+}
@@ -0,0 +1,81 @@
+/**
+    @file command.h
+    @author Sachi Vyas (smvyas)
+    A program that: The prototype for command.c
+ */
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+
+#ifndef COMMAND_H
+#define COMMAND_H
+
+#include "output.h"
+#include "stats.h"
+
+struct GroupStruct;
+struct ReloadStruct;
+
+/** Longest member id a sale command reads, the same as MAX_ID_LEN */
+#define SESSION_ID_LEN 8
+
+/**
+    Struct for one stream of commands run against a group. A sale command that can't be read echoes
+    what the last one read, so that is kept from one command to the next.
+ */
+struct SessionStruct {
+    struct GroupStruct *group;
+    Stats *stats;
+    char memberId[SESSION_ID_LEN + 1];
+    int itemId;
+    int numItemsSold;
+};
+typedef struct SessionStruct Session;
+
+/**
+    Initializes a session for running commands against a group.
+    @param *session the session to initialize
+    @param *group the group the commands work on
+    @param *stats the statistics to time the commands in, or NULL when built with NO_STATS
+ */
+void initSession( Session *session, struct GroupStruct *group, Stats *stats );
+/**
+    Checks if a command reloads the item or member file, so its file can be read by another thread.
+    @param *cmd the command
+    @return true if the command is a reload items or reload members command
+ */
+bool isReload( char const *cmd );
+/**
+    Reads the file of a reload command with prepareReload. No group is touched, so this can run on any thread.
+    @param *cmd the command, for which isReload is true
+    @return the file read for the reload, or NULL if it couldn't be opened or isn't valid
+ */
+struct ReloadStruct *readReloadFile( char const *cmd );
+/**
+    Finishes a reload command whose file was read by readReloadFile, perhaps on another thread: the file is
+    swapped into the session's group and the command's output is added. Only the time of the swap is counted.
+    @param *session the session the command belongs to
+    @param *cmd the command
+    @param *reload the file from readReloadFile, or NULL if it couldn't be read
+    @param *out the output to add to
+ */
+void finishReload( Session *session, char const *cmd, struct ReloadStruct *reload, Output *out );
+/**
+    Runs one command and adds its output, echo included, to an output. The command is split into words once
+    and looked up in the table of commands, whose run function reads the arguments. A list or search command
+    may end with "limit N" or "limit N offset M" to print only some of its rows.
+    @param *session the session the command belongs to
+    @param *cmd the command
+    @param *out the output to add to
+    @return true if the command was quit, which ends the session
+ */
+bool runCommand( Session *session, char const *cmd, Output *out );
+/**
+    Checks if a command only reads the group, so it can be run on a view of the group by another thread.
+    The command is matched the way runCommand matches it, page and all.
+    @param *cmd the command
+    @return true if runCommand would list or search with it and change nothing
+ */
+bool isReadOnly( char const *cmd );
+
+#endif
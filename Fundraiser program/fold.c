@@ -0,0 +1,101 @@
+/**
+    @file fold.c
+    @author Sachi Vyas (smvyas)
+    A program that: Keeps lowercase copies of names in fixed size slots, and checks them for a search string
+    sixteen bytes at a time where the processor allows it.
+ */
+#include "fold.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+/** Difference between an uppercase letter and its lowercase form */
+#define CASE_OFFSET ('a' - 'A')
+/** Number of bytes compared at once by the vector check */
+#define LANES 16
+
+/**
+    Makes the lowercase form of a character. Only ASCII letters are changed, so the result doesn't depend on
+    the locale.
+    @param ch the character
+    @return the lowercase form
+ */
+static char foldChar( char ch )
+{
+    return ch >= 'A' && ch <= 'Z' ? ch + CASE_OFFSET : ch;
+}
+
+/**
+    Makes a lowercase copy of a string.
+    @param *dest the place to store the copy, with room for the whole string
+    @param *str the string to copy
+    @return the length of the string
+ */
+int foldString( char *dest, char const *str )
+{
+    int len = 0;
+    while (str[len] != '\0') {
+        dest[len] = foldChar(str[len]);
+        len++;
+    }
+    dest[len] = '\0';
+    return len;
+}
+
+/**
+    Makes a pool of lowercase copies of names, each in its own FOLD_SLOT byte slot padded out with zeros, so
+    the name at position i starts at pool + i * FOLD_SLOT.
+    @param **names the names to copy, at most FOLD_SLOT - 1 characters each
+    @param count the number of names
+    @return the dynamically allocated pool
+ */
+char *makeFoldedPool( char const *const *names, int count )
+{
+    // one more slot of zeros lets a check read past the end of the last name
+    char *pool = (char *)calloc((size_t)(count + 1) * FOLD_SLOT, 1);
+    if (pool == NULL) {
+        fprintf(stderr, "Memory allocation issue.\n");
+        exit(EXIT_FAILURE);
+    }
+    for (int i = 0; i < count; i++) {
+        foldString(pool + (size_t) i * FOLD_SLOT, names[i]);
+    }
+    return pool;
+}
+
+/**
+    Checks if the folded name in a pool slot contains a folded search string.
+    @param *slot the slot of the name in the pool
+    @param *str the folded search string, from 1 to FOLD_SLOT - 1 characters long
+    @param len the length of the search string
+    @return true if the name contains the string
+ */
+bool foldedContains( char const *slot, char const *str, int len )
+{
+#ifdef __SSE2__
+    // find the places where both the first and the last character of the string line up, then compare the
+    // middle at just those places; a match can't run past the null at the end of the name
+    __m128i first = _mm_set1_epi8(str[0]);
+    __m128i last = _mm_set1_epi8(str[len - 1]);
+    for (int base = 0; base < FOLD_SLOT; base += LANES) {
+        __m128i starts = _mm_loadu_si128((__m128i const *)(slot + base));
+        __m128i ends = _mm_loadu_si128((__m128i const *)(slot + base + len - 1));
+        unsigned int mask = _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(starts, first),
+                                                            _mm_cmpeq_epi8(ends, last)));
+        while (mask != 0) {
+            int pos = base + __builtin_ctz(mask);
+            if (memcmp(slot + pos + 1, str + 1, len - 1) == 0) {
+                return true;
+            }
+            mask &= mask - 1;
+        }
+    }
+    return false;
+#else
+    return strstr(slot, str) != NULL;
+#endif
+}
@@ -0,0 +1,40 @@
+/**
+    @file fold.h
+    @author Sachi Vyas (smvyas)
+    A program that: The prototype for fold.c
+ */
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+
+#ifndef FOLD_H
+#define FOLD_H
+
+/** Bytes each folded name takes in a name pool, enough for a name, its null terminator and padding */
+#define FOLD_SLOT 32
+
+/**
+    Makes a pool of lowercase copies of names, each in its own FOLD_SLOT byte slot padded out with zeros, so
+    the name at position i starts at pool + i * FOLD_SLOT.
+    @param **names the names to copy, at most FOLD_SLOT - 1 characters each
+    @param count the number of names
+    @return the dynamically allocated pool
+ */
+char *makeFoldedPool( char const *const *names, int count );
+/**
+    Makes a lowercase copy of a string.
+    @param *dest the place to store the copy, with room for the whole string
+    @param *str the string to copy
+    @return the length of the string
+ */
+int foldString( char *dest, char const *str );
+/**
+    Checks if the folded name in a pool slot contains a folded search string.
+    @param *slot the slot of the name in the pool
+    @param *str the folded search string, from 1 to FOLD_SLOT - 1 characters long
+    @param len the length of the search string
+    @return true if the name contains the string
+ */
+bool foldedContains( char const *slot, char const *str, int len );
+
+#endif
@@ -4,136 +4,57 @@
     A program that: Helps us process the elements in the command line and print
     the output accordingly.
  */
+#define _POSIX_C_SOURCE 200809L
 #include "input.h"
 #include "group.h"
+#include "stats.h"
+#include "snapshot.h"
+#include "command.h"
+#include "server.h"
 #include <stdlib.h>
 #include <stdio.h>
 #include <stdbool.h>
 #include <string.h>
 #include <ctype.h>
+#include <unistd.h>
 
 /** Minimum number of commands on the command line */
 #define MIN_ARGS 3
-/** Length of the word */
-#define LENGTH 4
+/** Option that starts the program from a snapshot instead of an item and a member file */
+#define SNAPSHOT_OPTION "--snapshot"
+/** Option that serves clients on the named Unix domain socket instead of reading standard input */
+#define SERVE_OPTION "--serve"
+/** Option that keeps a journal of the sales in the named file */
+#define JOURNAL_OPTION "--journal"
+/** Environment variable giving the number of sales the journal commits to disk together */
+#define JOURNAL_BATCH_VAR "FUNDRAISER_JOURNAL_BATCH"
+/** Environment variable giving the longest time in milliseconds a sale waits to be committed */
+#define JOURNAL_MS_VAR "FUNDRAISER_JOURNAL_MS"
+/** Environment variable naming a file to write the statistics to on quit */
+#define STATS_FILE_VAR "FUNDRAISER_STATS"
+/** How the program is run, printed when the command line can't be read */
+#define USAGE "usage: fundraiser (item-file member-file | --snapshot snapshot-file) [--journal journal-file] " \
+              "[--serve socket-path]\n"
 /**
-    Checks if a string is contained in the item
-    @param *item a pointer to an item that we are currently looking at
-    @param *str a pointer to a str to compare
-    @return true if *str is equal to the name else returns false
+    Reads a number from an environment variable.
+    @param *name the name of the variable
+    @param fallback the number to use if the variable isn't set
+    @return the number
  */
-bool testItemNameEquals(Item const *item, char const *str) {
-    if (str == NULL || *str == '\0') {
-        return true;
-    }
-    return strstr(item -> nameOfItem, str) != NULL;
-}
-/**
-    Checks if a string is contained in the member pointer
-    @param *member a pointer to a member that we are currently looking at
-    @param *str a pointer to a str to compare
-    @return true if *str is equal to the name else returns false
- */
-bool testMemberNameEquals(Member const *member, char const *str) {
-    if (str == NULL || *str == '\0') {
-        return true;
-    }
-    return strstr(member -> name, str) != NULL;
-}
-/**
-    Compares two member id's
-    @param *va a pointer to a member id that we are currently looking at
-    @param *vb a pointer to a compare *va with
-    @return int returns 0 if *va and *vb are equal each other else returns 1
- */
-int compareMemberID(void const *va, void const *vb) {
-    Member *const *m1 = va;
-    Member *const *m2 = vb;
-    return strcmp((*m1) -> memberId, (*m2) -> memberId);
-}
-/**
-    Compares two item id's
-    @param *va a pointer to an item id that we are currently looking at
-    @param *vb a pointer to a compare *va with
-    @return int returns 0 if *va and *vb are equal each other else returns 1
- */
-int compareItemsID(void const *va, void const *vb) {
-    Item *const *i1 = va;
-    Item *const *i2 = vb;
-    if ((*i1) -> itemId < (*i2) -> itemId) {
-        return -1;
-    }
-    if ((*i1) -> itemId > (*i2) -> itemId) {
-        return 1;
-    }
-    return 0;
-}
-/**
-    Checks if two item names are equal
-    @param *va a pointer to an item name that we are currently looking at
-    @param *vb a pointer to an item name to compare with
-    @return 0 if *va is equal to *vb else returns false
- */
-int compareItemsByName(const void *va, const void *vb) {
-    const Item *i1 = *(const Item **)va; 
-    const Item *i2 = *(const Item **)vb; 
-    int compareNames = strcmp(i1 -> nameOfItem, i2 -> nameOfItem);
-    if (compareNames != 0) {
-        return compareNames;
-    }
-    if (i1 -> itemId < i2 -> itemId) {
-        return -1;
-    }
-    if (i1 -> itemId > i2 -> itemId) {
-        return 1;
-    }
-    return 0;
+static int envNumber( char const *name, int fallback )
+{
+    char const *value = getenv(name);
+    return value == NULL ? fallback : atoi(value);
 }
-/**
-    Checks if two member names are equal
-    @param *va a pointer to a member name that we are currently looking at
-    @param *vb a pointer to a member name to compare with
-    @return 0 if *va is equal to *vb else returns false
- */
-int compareMembersByName(const void *va, const void *vb) {
-    const Member *m1 = *(const Member **)va; 
-    const Member *m2 = *(const Member **)vb;
 
-    // First, compare by name
-    int compareNames = strcmp(m1 -> name, m2 -> name);
-    if (compareNames != 0) {
-        return compareNames;
-    }
-    return strcmp(m1 -> memberId, m2 -> memberId);
-}
 /**
-    Helps us compare the total cost of items sold by a member
-    @param *group a pointer to the group that we are currently looking at
-    @param totalCostArray an array containing the total cost of each item sold by the member
-    @param totalItemsSoldByMember an array containing the number of each item sold by the member
+    Waits for the sales recorded so far to be on disk, before output that acknowledges them is written.
+    @param *journal the journal the sales were added to
  */
-void compareTotalCost(Group *group, int totalCostArray[], int totalItemsSoldByMember[]) {
-    for (int i = 0; i < group -> mCount - 1; i++) {
-        for (int k = 0; k < group -> mCount - 1 - i; k++) {
-            if (totalCostArray[k] < totalCostArray[k + 1]) {
-                //getting the current member at which the pointer is pointing to
-                Member *currentMember = group -> mList[k];
-                //assigning the currentMember to the next idx since its cost sold is more
-                group -> mList[k] = group -> mList[k + 1];
-                group -> mList[k + 1] = currentMember;
-
-                //now swapping the total items sold by member
-                int currentItemsSoldByMember = totalItemsSoldByMember[k];
-                totalItemsSoldByMember[k] = totalItemsSoldByMember[k + 1];
-                totalItemsSoldByMember[k + 1] = currentItemsSoldByMember;
-
-                //swapping members with the highest cost of items
-                int currentCost = totalCostArray[k];
-                totalCostArray[k] = totalCostArray[k + 1];
-                totalCostArray[k + 1] = currentCost;
-            }
-        }
-    }
+static void syncSales( void *journal )
+{
+    // a journal that can't be written has said so, and the program fails when it ends
+    syncJournal(journal);
 }
 /**
     Returns an integer based on if the program successfully executed
@@ -144,247 +65,108 @@ void compareTotalCost(Group *group, int totalCostArray[], int totalItemsSoldByMe
 int main(int argc, char *argv[]) 
 {
     if (argc < MIN_ARGS) {
-        fprintf(stderr, "usage: fundraiser item-file member-file\n");
+        fprintf(stderr, USAGE);
         exit(EXIT_FAILURE);
     }
-    Group *group = makeGroup();
-    readItems(argv[1], group);
-    sortItems(group, compareItemsID);
-    readMembers(argv[DOUBLE_SIZE], group);
-    sortMembers(group, compareMemberID);
-    
-    FILE *outfile = stdout;
-
-    char memberId[MAX_ID_LEN + 1];
-    int itemId = 0, numItemsSold = 0;
-    char *cmd;
-    bool quitFound = false;
-
-    while ((cmd = readLine(stdin))) {
-        
-        if (strncmp(cmd, "quit", LENGTH) == 0) {
-            fprintf(outfile, "cmd> quit\n");
-            quitFound = true;
-            exit(EXIT_SUCCESS);
+    // options come in pairs after the item and member files or the snapshot; one that can't be read stops
+    // the program, so a misspelled option can't quietly turn the journal off
+    char const *journalFile = NULL;
+    char const *socketPath = NULL;
+    for (int i = MIN_ARGS; i < argc; i += DOUBLE_SIZE) {
+        if (i + 1 < argc && strcmp(argv[i], JOURNAL_OPTION) == 0) {
+            journalFile = argv[i + 1];
         }
-        else if (strncmp(cmd, "sale", LENGTH) == 0) {
-            if (sscanf(cmd, "sale %8s %d %d", memberId, &itemId, &numItemsSold) == MIN_ARGS) {
-
-                fprintf(outfile, "cmd> sale %s %d %d\n", memberId, itemId, numItemsSold);
-
-                int state = 0;
-                bool itempresent = false;
-                // Find member and item
-                for (int i = 0; i < group -> mCount; i++) {
-                    if (strcmp(group -> mList[i] -> memberId, memberId) == 0) {
-                      
-                        Member *m = group->mList[i];
-                        state = LENGTH;
-                        for (int j = 0; j < group->iCount; j++) {
-                            if (group -> iList[j] -> itemId == itemId) {
-                                Item *item = group -> iList[j];
-                                item -> numSold += numItemsSold;
-
-                                itempresent = false;
-                                // Update sold items for the member
-                                for (int k = 0; k < m -> soldItemCount; k++) {
-                                    SaleItem *sale = m -> soldItems[k];
-                                    if (sale -> item == item) {
-                                        sale -> quantity += numItemsSold;
-                                        itempresent = true;
-                                        break;
-                                    }
-                                }
-                                if (!itempresent) {
-                                    if (m -> soldItemCount == m -> soldItemCap) {
-                                        m -> soldItemCap *= DOUBLE_SIZE;
-                                        m -> soldItems = realloc(m -> soldItems, m -> soldItemCap * sizeof(SaleItem *));
-                                        if (!m -> soldItems) {
-                                            exit(EXIT_FAILURE);
-                                        }
-                                    }
-                                    // Create a new SaleItem
-                                    SaleItem *newSale = malloc(sizeof(SaleItem *));
-                                    newSale -> item = item;
-                                    newSale -> quantity = numItemsSold;
-
-                                    // Add the new SaleItem to the member's soldItems array
-                                    m -> soldItems[m -> soldItemCount++] = newSale;
-                                }
-                                break;
-                            }
-                        }
-                      
-                        break;
-                    }
-                }
-                if (state == 0) {
-                    fprintf(outfile, "Invalid command\n\n");
-                }
-                else {
-                    printf("%c", '\n');
-                }
-                
-            }
-            else {
-                fprintf(outfile, "cmd> sale %s %d %d\n", memberId, itemId, numItemsSold);
-                fprintf(outfile, "Invalid command\n");
-            }
-            
-        }        
-        else if (strcmp(cmd, "list items") == 0) {
-            fprintf(outfile, "cmd> list items\n");
-            fprintf(outfile, "%-3s %-30s %6s %6s %6s\n", "ID", "Name", "Cost", "Sold", "Total");
-            qsort(group -> iList, group -> iCount, sizeof(Item *), compareItemsID);
-            listItems(group, testItemNameEquals, NULL);
+        else if (i + 1 < argc && strcmp(argv[i], SERVE_OPTION) == 0) {
+            socketPath = argv[i + 1];
         }
-        else if (strcmp(cmd, "list item names") == 0) {
-            fprintf(outfile, "cmd> list item names\n");
-            fprintf(outfile, "%-3s %-30s %6s %6s %6s\n", "ID", "Name", "Cost", "Sold", "Total");
-            qsort(group -> iList, group -> iCount, sizeof(Item *), compareItemsByName);
-            listItems(group, testItemNameEquals, NULL);
-            
+        else {
+            fprintf(stderr, USAGE);
+            exit(EXIT_FAILURE);
         }
-        else if (strcmp(cmd, "list members") == 0) {
-            fprintf(outfile, "cmd> list members\n");
-            fprintf(outfile, "%-8s %-30s %6s %6s\n", "ID", "Name", "Sold", "Total");
-            qsort(group -> mList, group -> mCount, sizeof(Member *), compareMemberID);
-            listMembers(group, testMemberNameEquals, NULL);
+    }
 
+    Group *group;
+    if (strcmp(argv[1], SNAPSHOT_OPTION) == 0) {
+        // a snapshot already holds the sorted lists, the views and the indexes
+        group = loadSnapshot(argv[DOUBLE_SIZE]);
+        if (group == NULL) {
+            fprintf(stderr, "Invalid snapshot file: %s\n", argv[DOUBLE_SIZE]);
+            exit(EXIT_FAILURE);
         }
-        else if (strcmp(cmd, "list member names") == 0) {
-            fprintf(outfile, "cmd> list member names\n");
-            fprintf(outfile, "%-8s %-30s %6s %6s\n", "ID", "Name", "Sold", "Total");
-            qsort(group -> mList, group -> mCount, sizeof(Member *), compareMembersByName);
-            listMembers(group, testMemberNameEquals, NULL);
-            
-        }
-        else if (strcmp(cmd, "list topsellers") == 0) {
-            fprintf(outfile, "cmd> list topsellers\n");
-            fprintf(outfile, "%-8s %-30s %6s %6s\n", "ID", "Name", "Sold", "Total");
-            int totalItemsSold[group -> mCount];
-            int totalCost[group -> mCount];
-            
-            for (int i = 0; i < group -> mCount; i++) {
-                Member *m = group -> mList[i];
-                totalItemsSold[i] = 0;
-                totalCost[i] = 0;
-
-                // Calculate total items sold and total cost for this member
-                for (int j = 0; j < m -> soldItemCount; j++) {
-                    SaleItem *sale = m -> soldItems[j];
-                    totalItemsSold[i] += sale -> quantity;
-                    totalCost[i] += sale -> quantity * sale -> item -> cost;
-                }
-            }
-
-            compareTotalCost(group, totalCost, totalItemsSold);
-            listMembers(group, testMemberNameEquals, NULL);
+    }
+    else {
+        group = makeGroup();
+        readItems(argv[1], group);
+        sortItemsById(group);
+        readMembers(argv[DOUBLE_SIZE], group);
+        sortMembersById(group);
+        // the lists stay in id order from here on, other orders are views built once
+        group -> itemsByName = makeItemView(group, compareItemsByName);
+        group -> membersByName = makeMemberView(group, compareMembersByName);
+        indexNames(group);
+    }
+    // a journal keeps every sale across a crash, and brings back the sales of earlier runs
+    Journal *journal = NULL;
+    if (journalFile != NULL) {
+        journal = openJournal(journalFile, group, envNumber(JOURNAL_BATCH_VAR, JOURNAL_BATCH),
+                              envNumber(JOURNAL_MS_VAR, JOURNAL_INTERVAL_MS));
+        if (journal == NULL) {
+            fprintf(stderr, "Invalid journal file: %s\n", journalFile);
+            exit(EXIT_FAILURE);
         }
-        
-        else if (strstr(cmd, "list member") != NULL) {
-            
-            char memberId[MAX_ID_LEN + 1];
-            if (sscanf(cmd, "list member %s", memberId) != 1) {
-                fprintf(outfile, "Invalid command\n");
-                continue;
-            }
-
-            int state = 0;
-            //Finding the member with the given Id
-            Member *m = NULL;
-            for (int i = 0; i < group -> mCount; i++) {
-                if (strcmp(group -> mList[i] -> memberId, memberId) == 0) {
-                    m = group -> mList[i];
-                    state = 1;
-                    break;
-                }
-            }
-            if (state == 0) {
-                fprintf(outfile, "cmd> %s\n", cmd);
-                fprintf(outfile, "Invalid command\n\n");
-            }
-            else if (state == 1) {
-                int totalSold = 0, totalCost = 0;
-                fprintf(outfile, "cmd> list member %s\n", memberId);
-                fprintf(outfile, "%-3s %-30s %6s %6s %6s\n", "ID", "Name", "Cost", "Sold", "Total");
-
-                int itemCount = 0;
-                SaleItem *currentSales[MAX_NAME_LEN + 1];
-
-                // Get the sold items for this member
-                for (int i = 0; i < m -> soldItemCount; i++) {
-                    SaleItem *sale = m -> soldItems[i];
-                    bool found = false;
-                    for (int j = 0; j < itemCount; j++) {
-                        if (currentSales[j] -> item -> itemId == sale -> item -> itemId) {
-                            currentSales[j] -> quantity += sale -> quantity;
-                            found = true;
-                            break;
-                        }
-                    }
-                    if (!found) {
-                        currentSales[itemCount] = sale;
-                        itemCount++;
-                    }
-                }
-                // Sort by item ID
-                for (int i = 0; i < itemCount - 1; i++) {
-                    for (int j = 0; j < itemCount - 1 - i; j++) {
-                        if (currentSales[j] -> item -> itemId > currentSales[j + 1] -> item -> itemId) {
-                            SaleItem *current = currentSales[j];
-                            currentSales[j] = currentSales[j + 1];
-                            currentSales[j + 1] = current;
-                        }
-                    }
-                }
-                for (int i = 0; i < itemCount; i++) {         
-                    Item *item = currentSales[i] -> item;
-                    int sold = currentSales[i] -> quantity;
-                    int cost = sold * item -> cost;
-                    totalSold += sold;
-                    totalCost += cost;
-                    fprintf(outfile, "%-3d %-30s %6d %6d %6d\n", item -> itemId, item -> nameOfItem, item -> cost, sold, cost);
-                }
-
-                // Print the totals
-                fprintf(outfile, "%3s %-30s %6s %4d %6d\n\n", "TOTAL", "", "", totalSold, totalCost);
-                
-            }
+    }
+    
+    Session session;
+#ifndef NO_STATS
+    Stats stats;
+    initStats(&stats);
+    initSession(&session, group, &stats);
+#else
+    initSession(&session, group, NULL);
+#endif
+    bool quit = false;
+    long long bytesWritten = 0;
+
+    if (socketPath != NULL) {
+        if (!serve(socketPath, &session, &bytesWritten)) {
+            fprintf(stderr, "Can't serve on socket: %s\n", socketPath);
+            exit(EXIT_FAILURE);
         }
-
-        else if (strstr(cmd, "search item") != NULL) {
-            char searchStr[MAX_ID_LEN + 1];
-            if (sscanf(cmd, "search item %30s", searchStr) == 1) {
-                fprintf(outfile, "cmd> %s\n", cmd);
-                fprintf(outfile, "%-3s %-30s %6s %6s %6s\n", "ID", "Name", "Cost", "Sold", "Total");
-                listItems(group, testItemNameEquals, searchStr);
-            } 
-            else {
-                fprintf(outfile, "Invalid command\n");
-            }
+        quit = true;
+    }
+    else {
+        // everything for stdout goes through one buffer, flushed after each command when someone is watching
+        Output out;
+        initOutput(&out, STDOUT_FILENO);
+        if (journal != NULL) {
+            out.beforeWrite = syncSales;
+            out.beforeWriteArg = journal;
         }
-        else if (strstr(cmd, "search member") != NULL) {
-            char searchStr[MAX_NAME_LEN + 1]; 
-            if (sscanf(cmd, "search member %15s", searchStr) == 1) {
-                fprintf(outfile, "cmd> search member %s\n", searchStr);
-                fprintf(outfile, "%-8s %-30s %6s %6s\n", "ID", "Name", "Sold", "Total");
-                listMembers(group, testMemberNameEquals, searchStr);
-            } 
-            else {
-                fprintf(outfile, "Invalid command\n");
+        bool interactive = isatty(STDOUT_FILENO);
+        LineReader reader;
+        initLineReader(&reader, STDIN_FILENO);
+        char *cmd;
+        while (!quit && (cmd = nextLine(&reader))) {
+            quit = runCommand(&session, cmd, &out);
+            if (interactive) {
+                flushOutput(&out);
             }
         }
-        else {
-            fprintf(outfile, "cmd> %s\n", cmd);
-            fprintf(outfile, "Invalid command\n\n");
+        if (!quit) {
+            putFormat(&out, "cmd> ");
         }
+        bytesWritten = outputBytes(&out);
+        freeOutput(&out);
+        freeLineReader(&reader);
     }
-    if (quitFound == false) {
-        fprintf(outfile, "cmd> ");
-        exit(EXIT_SUCCESS);
-        
+
+#ifndef NO_STATS
+    char const *statsFile = getenv(STATS_FILE_VAR);
+    if (quit && statsFile != NULL && !dumpStats(&stats, bytesWritten, statsFile)) {
+        fprintf(stderr, "Can't write file: %s\n", statsFile);
     }
-    fclose(outfile);
-    return EXIT_SUCCESS;
+#endif
+    bool journaled = journal == NULL || closeJournal(journal);
+    freeGroup(group);
+    return journaled ? EXIT_SUCCESS : EXIT_FAILURE;
 }
@@ -6,15 +6,189 @@
  */
 #include "input.h"
 #include "group.h"
+#include "arena.h"
+#include "radix.h"
 #include <stdlib.h>
 #include <stdio.h>
 #include <stdbool.h>
 #include <string.h>
 #include <ctype.h>
-/** Number of items to read from each line from the items file */
-#define VAR_ITEMS 3
-/** Number of things to read from each line from the members file */
-#define VAR_MEMBERS 2
+/** Marks an empty slot in the member and item indexes */
+#define EMPTY_SLOT -1
+/** Multiplier used to scatter item ids across the item index */
+#define ITEM_HASH_MULTIPLIER 2654435761u
+/** Shift used to fold the high bits of an item id hash into the low bits */
+#define ITEM_HASH_SHIFT 16
+/** Multiplier used to scatter packed member ids across the member index */
+#define MEMBER_HASH_MULTIPLIER 0x9E3779B97F4A7C15ull
+/** Shift that keeps the well mixed high bits of a member id hash */
+#define MEMBER_HASH_SHIFT 32
+/** Number of bits in a byte of a packed member id */
+#define BYTE_BITS 8
+/** Width of the id column of an item listing */
+#define ITEM_ID_WIDTH 3
+/** Width of the number columns of a listing */
+#define NUMBER_WIDTH 6
+
+/**
+    Hashes an item id for the item index.
+    @param itemId the id to hash
+    @return the hash value for the id
+ */
+static unsigned int hashItemId( int itemId )
+{
+    unsigned int h = (unsigned int) itemId * ITEM_HASH_MULTIPLIER;
+    return h ^ (h >> ITEM_HASH_SHIFT);
+}
+
+/**
+    Hashes a packed member id for the member index.
+    @param idKey the packed id to hash
+    @return the hash value for the id
+ */
+static unsigned int hashMemberId( unsigned long long idKey )
+{
+    return (unsigned int)((idKey * MEMBER_HASH_MULTIPLIER) >> MEMBER_HASH_SHIFT);
+}
+
+/**
+    Allocates an index table with every slot empty.
+    @param cap the number of slots in the table, a power of two
+    @return the new table
+ */
+static int *makeTable( int cap )
+{
+    int *table = (int *)malloc(cap * sizeof(int));
+    if (table == NULL) {
+        fprintf(stderr, "Memory allocation issue.\n");
+        exit(EXIT_FAILURE);
+    }
+    for (int i = 0; i < cap; i++) {
+        table[i] = EMPTY_SLOT;
+    }
+    return table;
+}
+
+/**
+    Places the position of an item in the first free slot of the item table, using linear probing.
+    @param *group the group whose item index is being filled
+    @param pos the position of the item in the item list
+ */
+static void placeItem( Group *group, int pos )
+{
+    unsigned int mask = group -> iTableCap - 1;
+    unsigned int slot = hashItemId(group -> itemIds[pos]) & mask;
+    while (group -> iTable[slot] != EMPTY_SLOT) {
+        slot = (slot + 1) & mask;
+    }
+    group -> iTable[slot] = pos;
+}
+
+/**
+    Places the position of a member in the first free slot of the member table, using linear probing.
+    @param *group the group whose member index is being filled
+    @param pos the position of the member in the member list
+ */
+static void placeMember( Group *group, int pos )
+{
+    unsigned int mask = group -> mTableCap - 1;
+    unsigned int slot = hashMemberId(group -> mList[pos] -> idKey) & mask;
+    while (group -> mTable[slot] != EMPTY_SLOT) {
+        slot = (slot + 1) & mask;
+    }
+    group -> mTable[slot] = pos;
+}
+
+/**
+    Rebuilds the item index from the item list, with a table of the given size.
+    @param *group the group whose item index is rebuilt
+    @param cap the number of slots for the table, a power of two
+ */
+static void reindexItems( Group *group, int cap )
+{
+    free(group -> iTable);
+    group -> iTable = makeTable(cap);
+    group -> iTableCap = cap;
+    for (int i = 0; i < group -> iCount; i++) {
+        placeItem(group, i);
+    }
+}
+
+/**
+    Rebuilds the member index from the member list, with a table of the given size.
+    @param *group the group whose member index is rebuilt
+    @param cap the number of slots for the table, a power of two
+ */
+static void reindexMembers( Group *group, int cap )
+{
+    free(group -> mTable);
+    group -> mTable = makeTable(cap);
+    group -> mTableCap = cap;
+    for (int i = 0; i < group -> mCount; i++) {
+        placeMember(group, i);
+    }
+}
+
+/**
+    Adds the item at the end of the item list to the group's item index, doubling the table first if it would
+    become more than half full.
+    @param *group the group whose index the item is added to
+ */
+static void indexItem( Group *group )
+{
+    if ((group -> iCount + 1) * DOUBLE_SIZE > group -> iTableCap) {
+        reindexItems(group, group -> iTableCap * DOUBLE_SIZE);
+    }
+    placeItem(group, group -> iCount);
+}
+
+/**
+    Adds the member at the end of the member list to the group's member index, doubling the table first if it
+    would become more than half full.
+    @param *group the group whose index the member is added to
+ */
+static void indexMember( Group *group )
+{
+    if ((group -> mCount + 1) * DOUBLE_SIZE > group -> mTableCap) {
+        reindexMembers(group, group -> mTableCap * DOUBLE_SIZE);
+    }
+    placeMember(group, group -> mCount);
+}
+
+/**
+    Resizes the item columns of a group so they hold a number of items.
+    @param *group the group whose columns are resized
+    @param cap the number of items the columns hold
+ */
+static void resizeItems( Group *group, int cap )
+{
+    int *ids = realloc(group -> itemIds, cap * sizeof(int));
+    if (ids != NULL) {
+        group -> itemIds = ids;
+    }
+    int *costs = realloc(group -> itemCosts, cap * sizeof(int));
+    if (costs != NULL) {
+        group -> itemCosts = costs;
+    }
+    long long *sold = realloc(group -> itemSold, cap * sizeof(long long));
+    if (sold != NULL) {
+        group -> itemSold = sold;
+    }
+    long long *revenue = realloc(group -> itemRevenue, cap * sizeof(long long));
+    if (revenue != NULL) {
+        group -> itemRevenue = revenue;
+    }
+    char *names = realloc(group -> itemNamePool, (size_t) cap * NAME_SLOT);
+    if (names != NULL) {
+        group -> itemNamePool = names;
+    }
+    if (ids == NULL || costs == NULL || sold == NULL || revenue == NULL || names == NULL) {
+        fprintf(stderr, "Memory allocation issue.\n");
+        exit(EXIT_FAILURE);
+    }
+    group -> iCap = cap;
+}
+
 /**
     Dynamically allocates storage for the Group, initializes its fields (to store the two resizable arrays) 
     and returns a pointer to the new Group.
@@ -23,14 +197,19 @@
 Group *makeGroup() 
 {
     Group *g = (Group*)malloc(sizeof(Group));
-
-    g -> iList = (Item **)malloc(INITIAL_SIZE * sizeof(Item *));
-    if (g -> iList == NULL) {
+    if (g == NULL) {
         fprintf(stderr, "Memory allocation issue.\n");
         exit(EXIT_FAILURE);
     }
+    initArena(&g -> arena);
+
+    g -> itemIds = NULL;
+    g -> itemCosts = NULL;
+    g -> itemSold = NULL;
+    g -> itemRevenue = NULL;
+    g -> itemNamePool = NULL;
+    resizeItems(g, INITIAL_SIZE);
     g -> iCount = 0;
-    g -> iCap = INITIAL_SIZE;
 
     g -> mList = (Member **)malloc(INITIAL_SIZE * sizeof(Member *));
     if (g -> mList == NULL) {
@@ -39,280 +218,1083 @@ Group *makeGroup()
     }
     g -> mCount = 0;
     g -> mCap = INITIAL_SIZE;
+
+    g -> iTable = makeTable(INITIAL_TABLE_SIZE);
+    g -> mTable = makeTable(INITIAL_TABLE_SIZE);
+    g -> iTableCap = INITIAL_TABLE_SIZE;
+    g -> mTableCap = INITIAL_TABLE_SIZE;
+    initLeaderboard(&g -> sellers);
+    g -> itemsByName = NULL;
+    g -> membersByName = NULL;
+    g -> itemNames.keyCount = 0;
+    g -> itemNames.keys = NULL;
+    g -> itemNames.starts = NULL;
+    g -> itemNames.postings = NULL;
+    g -> memberNames = g -> itemNames;
+    g -> foldedItemNames = g -> itemNames;
+    g -> foldedMemberNames = g -> itemNames;
+    g -> itemsFolded = NULL;
+    g -> membersFolded = NULL;
+    g -> snapshot = NULL;
+    g -> snapshotSize = 0;
+    g -> snapshotRead = false;
+    g -> journal = NULL;
+    g -> journalId = 0;
+    g -> journalRecords = 0;
+    g -> versions = NULL;
     return g;
 }
 
 /**
-    Function frees the memory used to store the given Group, including freeing space for all the Items, 
+    Checks if some storage of a group lies in the snapshot file the group was loaded from.
+    @param *group the group
+    @param *storage the storage
+    @return true if the storage is part of the mapped snapshot, and goes when it is unmapped
+ */
+bool inSnapshot( Group const *group, void const *storage )
+{
+    char const *p = storage;
+    return group -> snapshot != NULL && p >= group -> snapshot && p < group -> snapshot + group -> snapshotSize;
+}
+
+/**
+    Frees storage of a group, unless it lies in the snapshot the group was loaded from.
+    @param *group the group
+    @param *storage the storage, or NULL
+ */
+static void freeOwned( Group const *group, void *storage )
+{
+    if (!inSnapshot(group, storage)) {
+        free(storage);
+    }
+}
+
+/**
+    Frees a trigram index of a group, unless its lists lie in the snapshot the group was loaded from.
+    @param *group the group
+    @param *index the index
+ */
+static void freeOwnedIndex( Group const *group, TrigramIndex *index )
+{
+    freeOwned(group, index -> keys);
+    freeOwned(group, index -> starts);
+    freeOwned(group, index -> postings);
+}
+
+/**
+    Function frees the memory used to store the given Group, including freeing the item columns, the
     Members, and Member SaleItem lists, freeing the resizable arrays of pointers and freeing space for the Group struct 
-    itself.
+    itself. The Members and SaleItem lists all live in the group's arena, so they go with a handful of
+    chunk frees. A group loaded from a snapshot keeps its records, indexes and name orders in the mapped
+    snapshot file, so those go when the file is unmapped; only what a reload has replaced since is freed.
     @param *group the group to free, or empty the allocated memory of
  */
 void freeGroup( Group *group ) 
 {
-    free(group -> iList);
+    if (group -> versions != NULL) {
+        freeVersions(group);
+    }
+    freeArena(&group -> arena);
     free(group -> mList);
+    freeLeaderboard(&group -> sellers);
+    freeOwned(group, group -> itemIds);
+    freeOwned(group, group -> itemCosts);
+    freeOwned(group, group -> itemSold);
+    freeOwned(group, group -> itemRevenue);
+    freeOwned(group, group -> itemNamePool);
+    freeOwned(group, group -> iTable);
+    freeOwned(group, group -> mTable);
+    freeOwned(group, group -> itemsByName);
+    freeOwned(group, group -> membersByName);
+    freeOwnedIndex(group, &group -> itemNames);
+    freeOwnedIndex(group, &group -> memberNames);
+    freeOwned(group, group -> itemsFolded);
+    freeOwned(group, group -> membersFolded);
+    freeOwnedIndex(group, &group -> foldedItemNames);
+    freeOwnedIndex(group, &group -> foldedMemberNames);
+    if (group -> snapshot != NULL) {
+        MappedFile file = { group -> snapshot, group -> snapshotSize, group -> snapshotRead };
+        unmapFile(&file);
+    }
     free(group);
 }
 
 /**
-    Function reads all the items from an item file with the given name. It makes an instance 
-    of the Item struct for an item in the file and stores a pointer to that Item in the resizable item array in group.
+    Reads all the items from an item file into the end of a group's item columns, which are resized as needed.
+    The file is mapped into memory and each line is parsed in place, accepting exactly what
+    sscanf(line, "%d %d %30[^\n]") would: an id, a cost and the rest of the line, cut to 30 characters, as the name.
+    Nothing is reported, so the caller decides what a bad file means.
     @param *filename the pointer to a file to read in
-    @param *group allows us to access the actual group variable or object that is being pointed at
+    @param *group the group to add the items to
+    @return FILE_READ, FILE_MISSING if the file couldn't be opened or FILE_INVALID if a line is invalid
  */
-void readItems( char const *filename, Group *group )
+int parseItems( char const *filename, Group *group )
 {
-    FILE *fp = fopen(filename, "r");
-    if (!fp) {
-        fprintf(stderr, "Can't open file: %s\n", filename);
-        exit(EXIT_FAILURE);
+    MappedFile file;
+    if (!mapFile(filename, &file)) {
+        return FILE_MISSING;
     }
-    //creating a pointer in the file   
-    char *l = NULL;
-    
-    while ((l = readLine(fp)) != NULL) {
-        Item *newItem = malloc(sizeof(Item));
-        newItem -> numSold = 0;
-        if (newItem == NULL) {
-            fprintf(stderr, "Invalid items file: %s\n", filename);
-            free(l);
-            fclose(fp);
-            exit(EXIT_FAILURE);
+    char const *p = file.data;
+    char const *end = file.data + file.size;
+    while (p < end) {
+        char const *eol = memchr(p, '\n', end - p);
+        if (eol == NULL) {
+            eol = end;
         }
+        int itemId = 0;
+        int cost = 0;
 
-        //reading in the file
-        if (sscanf(l, "%d %d %30[^\n]", &newItem -> itemId, &newItem -> cost, newItem -> nameOfItem) != VAR_ITEMS) {
-            fprintf(stderr, "Invalid item file: %s\n", filename);
-            free(newItem);
-            freeGroup(group);
-            fclose(fp);
-            exit(EXIT_FAILURE);
+        //reading in the line
+        char const *q = scanInt(p, eol, &itemId);
+        if (q != NULL) {
+            q = scanInt(q, eol, &cost);
         }
-
-        //checking if the id and cost are valid
-        if (newItem -> itemId <= 0 || newItem -> cost <= 0) {
-            fprintf(stderr, "Invalid item file: %s\n", filename);
-            free(newItem);
-            //free(l);
-            freeGroup(group);
-            fclose(fp);
-            exit(EXIT_FAILURE);
+        if (q != NULL) {
+            q = skipBlanks(q, eol);
         }
-
-        //invalid name of item
-        if (strlen(newItem -> nameOfItem) > MAX_NAME_LEN) {
-            fprintf(stderr, "Invalid item file: %s\n", filename);
-            free(newItem);
-            freeGroup(group);
-            fclose(fp);
-            exit(EXIT_FAILURE);
+        if (q == NULL || q == eol) {
+            unmapFile(&file);
+            return FILE_INVALID;
+        }
+        size_t len = eol - q;
+        if (len > MAX_NAME_LEN) {
+            len = MAX_NAME_LEN;
         }
 
-        //check if two or more items have the same id
-        for (int i = 0; i < group -> iCount; i++) {
-            if (group -> iList[i] -> itemId == newItem -> itemId) {
-                fprintf(stderr, "Invalid item file: %s\n", filename);
-                // free(newItem);
-                // free(l);
-                freeGroup(group);
-                fclose(fp);
-                exit(EXIT_FAILURE);
-            }
+        //checking if the id and cost are valid, and that no two items have the same id
+        if (itemId <= 0 || cost <= 0 || findItemIndex(group, itemId) != EMPTY_SLOT) {
+            unmapFile(&file);
+            return FILE_INVALID;
         }
-        //resize the array if needed
+        //resize the columns if needed
         if (group -> iCount >= group -> iCap) {
-            group -> iCap *= DOUBLE_SIZE;
-            Item **newListItem = realloc(group -> iList, group -> iCap * sizeof(Item *));
-            if (newListItem == NULL) {
-                fprintf(stderr, "Invalid item file: %s\n", filename);
-                // free(newItem);
-                // free(l);
-                freeGroup(group);
-                fclose(fp);
-                exit(EXIT_FAILURE);
-            }
-            group -> iList = newListItem;
+            resizeItems(group, group -> iCap * DOUBLE_SIZE);
         }
-        group -> iList[group -> iCount++] = newItem;
-        free(l);
+        int i = group -> iCount;
+        group -> itemIds[i] = itemId;
+        group -> itemCosts[i] = cost;
+        group -> itemSold[i] = 0;
+        group -> itemRevenue[i] = 0;
+        char *name = group -> itemNamePool + (size_t) i * NAME_SLOT;
+        memset(name, 0, NAME_SLOT);
+        memcpy(name, q, len);
+        indexItem(group);
+        group -> iCount++;
+        p = eol + 1;
     }
-    fclose(fp);
+    unmapFile(&file);
+    return FILE_READ;
 }
 
 /**
-    Function sorts the items in the given group. It uses the qsort() function together with the function 
-    pointer parameter to order the items.
+    Function reads all the items from an item file with the given name. Each item in the file is added
+    to the end of the group's item columns, which are resized as needed. The file is parsed by parseItems, and
+    the program exits if it can't be opened or isn't valid.
     @param *filename the pointer to a file to read in
     @param *group allows us to access the actual group variable or object that is being pointed at
  */
-void readMembers( char const *filename, Group *group ) 
+void readItems( char const *filename, Group *group )
 {
-    FILE *fp = fopen(filename, "r");
-    if (!fp) {
+    int status = parseItems(filename, group);
+    if (status == FILE_MISSING) {
         fprintf(stderr, "Can't open file: %s\n", filename);
         exit(EXIT_FAILURE);
     }
-    char *l = NULL;
-    while((l = readLine(fp)) != NULL) {
-        Member *newMember = malloc(sizeof(Member));
+    if (status == FILE_INVALID) {
+        fprintf(stderr, "Invalid item file: %s\n", filename);
+        freeGroup(group);
+        exit(EXIT_FAILURE);
+    }
+}
+
+/**
+    Reads all the members from a member file into a group. It makes an instance of the Member struct for each
+    line of the file and stores a pointer to it in the resizable member array in group.
+    The file is mapped into memory and each line is parsed in place, accepting exactly what
+    sscanf(line, "%8s %[^\n]") would: up to 8 non-blank characters as the id and the rest of the line as the name.
+    Nothing is reported, so the caller decides what a bad file means.
+    @param *filename the pointer to a file to read in
+    @param *group the group to add the members to
+    @return FILE_READ, FILE_MISSING if the file couldn't be opened or FILE_INVALID if a line is invalid
+ */
+int parseMembers( char const *filename, Group *group )
+{
+    MappedFile file;
+    if (!mapFile(filename, &file)) {
+        return FILE_MISSING;
+    }
+    char const *p = file.data;
+    char const *end = file.data + file.size;
+    while (p < end) {
+        char const *eol = memchr(p, '\n', end - p);
+        if (eol == NULL) {
+            eol = end;
+        }
+        Member *newMember = (Member *)arenaAlloc(&group -> arena, sizeof(Member));
+        // the sales list is allocated on the member's first sale
+        newMember -> soldItems = NULL;
         newMember -> soldItemCount = 0;
-        if (newMember == NULL) {
-            fprintf(stderr, "Invalid member file: %s\n", filename);
-            // free(l);
-            freeGroup(group);
-            fclose(fp);
-            exit(EXIT_FAILURE);
+        newMember -> soldItemCap = 0;
+        newMember -> totalSold = 0;
+        newMember -> revenue = 0;
+
+        //reading in the id, which stops at a blank or after 8 characters
+        char const *q = skipBlanks(p, eol);
+        size_t len = 0;
+        while (q + len < eol && len < MAX_ID_LEN && !isBlank(q[len])) {
+            len++;
         }
-        newMember -> soldItems = malloc(INITIAL_SIZE * sizeof(SaleItem));
-        if (newMember -> soldItems == NULL) {
-            fprintf(stderr, "Invalid member file: %s\n", filename);
-            free(newMember);
-            // free(l);
-            freeGroup(group);
-            fclose(fp);
-            exit(EXIT_FAILURE);
+        if (len == 0) {
+            unmapFile(&file);
+            return FILE_INVALID;
         }
+        memcpy(newMember -> memberId, q, len);
+        newMember -> memberId[len] = '\0';
+        newMember -> idKey = packMemberId(newMember -> memberId);
 
-        newMember -> soldItemCount = 0;
-        newMember -> soldItemCap = INITIAL_SIZE;
-        if (sscanf(l, "%8s %[^\n]", newMember -> memberId, newMember -> name) != VAR_MEMBERS) {
-            fprintf(stderr, "Invalid member file: %s\n", filename);
-            // free(newMember);
-            // free(l);
-            freeGroup(group);
-            fclose(fp);
-            exit(EXIT_FAILURE);
-        }
-        
-        //invalid inputs
-        if (strlen(newMember -> memberId) > MAX_ID_LEN || strlen(newMember -> name) > MAX_NAME_LEN) {
-            fprintf(stderr, "Invalid member file: %s\n", filename);
-            // free(newMember);
-            // free(l);
-            freeGroup(group);
-            fclose(fp);
-            exit(EXIT_FAILURE);
+        //the name is the rest of the line
+        q = skipBlanks(q + len, eol);
+        len = eol - q;
+        if (len == 0 || len > MAX_NAME_LEN) {
+            unmapFile(&file);
+            return FILE_INVALID;
         }
+        memcpy(newMember -> name, q, len);
+        newMember -> name[len] = '\0';
 
         //check for duplicate ID
-        for (int i = 0; i < group -> mCount; i++) {
-            if (strcmp(group -> mList[i] -> memberId, newMember -> memberId) == 0) {
-                fprintf(stderr, "Invalid member file: %s\n", filename);
-                // free(newMember);
-                // free(l);
-                freeGroup(group);
-                exit(EXIT_FAILURE);
-                fclose(fp);
-               
-            }
+        if (findMemberIndex(group, newMember -> memberId) != EMPTY_SLOT) {
+            unmapFile(&file);
+            return FILE_INVALID;
         }
 
         //resize array if needed
         if (group -> mCount >= group -> mCap) {
-            group->mCap *= DOUBLE_SIZE;
+            group -> mCap *= DOUBLE_SIZE;
             Member **newListMember = realloc(group -> mList, group -> mCap * sizeof(Member *));
-            group->mList = newListMember;
             if (newListMember == NULL) {
-                fprintf(stderr, "Invalid member file: %s\n", filename);
-                // free(newMember);
-                // free(l);
-                freeGroup(group);
-                fclose(fp);
+                fprintf(stderr, "Memory allocation issue.\n");
                 exit(EXIT_FAILURE);
             }
             group -> mList = newListMember;
         }
-        group -> mList[group -> mCount++] = newMember;
-        free(l);
+        group -> mList[group -> mCount] = newMember;
+        indexMember(group);
+        group -> mCount++;
+        newMember -> boardSlot = addSeller(&group -> sellers, newMember);
+        p = eol + 1;
+    }
+    unmapFile(&file);
+    return FILE_READ;
+}
 
+/**
+    Function reads all the members from a member file with the given name. It makes an instance of the Member
+    struct for each line of the file and stores a pointer to it in the resizable member array in group. The file
+    is parsed by parseMembers, and the program exits if it can't be opened or isn't valid.
+    @param *filename the pointer to a file to read in
+    @param *group allows us to access the actual group variable or object that is being pointed at
+ */
+void readMembers( char const *filename, Group *group )
+{
+    int status = parseMembers(filename, group);
+    if (status == FILE_MISSING) {
+        fprintf(stderr, "Can't open file: %s\n", filename);
+        exit(EXIT_FAILURE);
+    }
+    if (status == FILE_INVALID) {
+        fprintf(stderr, "Invalid member file: %s\n", filename);
+        freeGroup(group);
+        exit(EXIT_FAILURE);
     }
-    fclose(fp);
 }
 
 /**
-    Function sorts the items in the given group. It uses the qsort() function together with 
-    the function pointer parameter to order the items.
+    Makes a copy of a column with its entries in a new order.
+    @param *column the column
+    @param width the size of an entry
+    @param *order the position in the column of each entry of the copy
+    @param count the number of entries
+    @param cap the number of entries to make room for
+    @return the dynamically allocated copy
+ */
+static void *gatherColumn( void const *column, size_t width, int const *order, int count, int cap )
+{
+    char *gathered = (char *)malloc((size_t) cap * width);
+    if (gathered == NULL) {
+        fprintf(stderr, "Memory allocation issue.\n");
+        exit(EXIT_FAILURE);
+    }
+    for (int i = 0; i < count; i++) {
+        memcpy(gathered + (size_t) i * width, (char const *) column + (size_t) order[i] * width, width);
+    }
+    return gathered;
+}
+
+/**
+    Moves every item column into a new order and rebuilds the item index for it.
+    @param *group the group whose items are reordered
+    @param *order the position in the item list of each item in the new order
+ */
+static void reorderItems( Group *group, int const *order )
+{
+    int n = group -> iCount;
+    int cap = group -> iCap;
+    int *ids = gatherColumn(group -> itemIds, sizeof(int), order, n, cap);
+    int *costs = gatherColumn(group -> itemCosts, sizeof(int), order, n, cap);
+    long long *sold = gatherColumn(group -> itemSold, sizeof(long long), order, n, cap);
+    long long *revenue = gatherColumn(group -> itemRevenue, sizeof(long long), order, n, cap);
+    char *names = gatherColumn(group -> itemNamePool, NAME_SLOT, order, n, cap);
+    free(group -> itemIds);
+    free(group -> itemCosts);
+    free(group -> itemSold);
+    free(group -> itemRevenue);
+    free(group -> itemNamePool);
+    group -> itemIds = ids;
+    group -> itemCosts = costs;
+    group -> itemSold = sold;
+    group -> itemRevenue = revenue;
+    group -> itemNamePool = names;
+    reindexItems(group, group -> iTableCap);
+}
+
+/**
+    Sorts the items in the given group by id, with a radix sort of the ids. The item index is rebuilt for the
+    new order.
     @param *group the pointer to a group to sort the items in
-    @param *compare is a pointer to a comparison function to help us sort items
  */
-void sortItems( Group *group, int (* compare) (void const *va, void const *vb )) 
+void sortItemsById( Group *group )
 {
-    if (group -> iCount > 0) {
-        qsort(group -> iList, group -> iCount, sizeof(Item *), compare);
+    unsigned long long *keys = (unsigned long long *)malloc((group -> iCount + 1) * sizeof(unsigned long long));
+    if (keys == NULL) {
+        fprintf(stderr, "Memory allocation issue.\n");
+        exit(EXIT_FAILURE);
+    }
+    // ids are positive, so they order the same as unsigned keys
+    for (int i = 0; i < group -> iCount; i++) {
+        keys[i] = (unsigned long long) group -> itemIds[i];
     }
+    int *order = radixOrder(keys, group -> iCount);
+    reorderItems(group, order);
+    free(order);
+    free(keys);
 }
 
 /**
-    This function sorts the members in the given group. It uses the qsort() function together with the 
-    function pointer parameter to order the members.
+    Sorts the members in the given group by id, with a radix sort of the packed ids. The member index is
+    rebuilt for the new order.
     @param *group the pointer to a group to sort the members in
-    @param *compare is a pointer to a comparison function to help us sort members
  */
-void sortMembers( Group *group, int (* compare) (void const *va, void const *vb )) 
+void sortMembersById( Group *group )
+{
+    unsigned long long *keys = (unsigned long long *)malloc((group -> mCount + 1) * sizeof(unsigned long long));
+    Member **sorted = (Member **)malloc(group -> mCap * sizeof(Member *));
+    if (keys == NULL || sorted == NULL) {
+        fprintf(stderr, "Memory allocation issue.\n");
+        exit(EXIT_FAILURE);
+    }
+    for (int i = 0; i < group -> mCount; i++) {
+        keys[i] = group -> mList[i] -> idKey;
+    }
+    int *order = radixOrder(keys, group -> mCount);
+    for (int i = 0; i < group -> mCount; i++) {
+        sorted[i] = group -> mList[order[i]];
+    }
+    free(group -> mList);
+    group -> mList = sorted;
+    reindexMembers(group, group -> mTableCap);
+    free(order);
+    free(keys);
+}
+
+/**
+    Checks if two item names are equal
+    @param *va a pointer to an item name that we are currently looking at
+    @param *vb a pointer to an item name to compare with
+    @return 0 if *va is equal to *vb else returns false
+ */
+int compareItemsByName(const void *va, const void *vb) {
+    const ItemKey *i1 = va; 
+    const ItemKey *i2 = vb; 
+    int compareNames = strcmp(i1 -> name, i2 -> name);
+    if (compareNames != 0) {
+        return compareNames;
+    }
+    if (i1 -> itemId < i2 -> itemId) {
+        return -1;
+    }
+    if (i1 -> itemId > i2 -> itemId) {
+        return 1;
+    }
+    return 0;
+}
+
+/**
+    Checks if two member names are equal
+    @param *va a pointer to a member name that we are currently looking at
+    @param *vb a pointer to a member name to compare with
+    @return 0 if *va is equal to *vb else returns false
+ */
+int compareMembersByName(const void *va, const void *vb) {
+    const Member *m1 = *(const Member **)va; 
+    const Member *m2 = *(const Member **)vb;
+
+    // First, compare by name
+    int compareNames = strcmp(m1 -> name, m2 -> name);
+    if (compareNames != 0) {
+        return compareNames;
+    }
+    if (m1 -> idKey < m2 -> idKey) {
+        return -1;
+    }
+    if (m1 -> idKey > m2 -> idKey) {
+        return 1;
+    }
+    return 0;
+}
+
+/** Pairs a member with its position in the member list, so qsort can order positions with a member comparison */
+struct MemberSlotStruct {
+    Member *member;
+    int index;
+};
+typedef struct MemberSlotStruct MemberSlot;
+
+/**
+    Builds a view of the items: the positions in the item list, in the order given by the comparison function.
+    The item list must not be reordered while the view is in use.
+    @param *group the pointer to a group to build the view of
+    @param *compare is a pointer to a comparison function for ItemKeys, as used with qsort
+    @return a dynamically allocated array of iCount positions in the item list
+ */
+int *makeItemView( Group const *group, int (* compare) (void const *va, void const *vb ))
+{
+    int *view = (int *)malloc((group -> iCount + 1) * sizeof(int));
+    ItemKey *keys = (ItemKey *)malloc((group -> iCount + 1) * sizeof(ItemKey));
+    if (view == NULL || keys == NULL) {
+        fprintf(stderr, "Memory allocation issue.\n");
+        exit(EXIT_FAILURE);
+    }
+    for (int i = 0; i < group -> iCount; i++) {
+        keys[i].itemId = group -> itemIds[i];
+        keys[i].name = itemName(group, i);
+        keys[i].index = i;
+    }
+    qsort(keys, group -> iCount, sizeof(ItemKey), compare);
+    for (int i = 0; i < group -> iCount; i++) {
+        view[i] = keys[i].index;
+    }
+    free(keys);
+    return view;
+}
+
+/**
+    Builds a view of the members: the positions in the member list, in the order given by the comparison function.
+    The member list must not be reordered while the view is in use.
+    @param *group the pointer to a group to build the view of
+    @param *compare is a pointer to a comparison function for pointers to members, as used with qsort
+    @return a dynamically allocated array of mCount positions in the member list
+ */
+int *makeMemberView( Group const *group, int (* compare) (void const *va, void const *vb ))
+{
+    int *view = (int *)malloc((group -> mCount + 1) * sizeof(int));
+    MemberSlot *slots = (MemberSlot *)malloc((group -> mCount + 1) * sizeof(MemberSlot));
+    if (view == NULL || slots == NULL) {
+        fprintf(stderr, "Memory allocation issue.\n");
+        exit(EXIT_FAILURE);
+    }
+    for (int i = 0; i < group -> mCount; i++) {
+        slots[i].member = group -> mList[i];
+        slots[i].index = i;
+    }
+    // the member pointer comes first in each slot, so the comparison function sees a Member **
+    qsort(slots, group -> mCount, sizeof(MemberSlot), compare);
+    for (int i = 0; i < group -> mCount; i++) {
+        view[i] = slots[i].index;
+    }
+    free(slots);
+    return view;
+}
+
+/** Struct for a listing being printed: where it goes, the page of rows to print, the rows so far and its totals */
+struct ListingStruct {
+    Output *out;
+    Page const *page;
+    int row;
+    long long sold;
+    long long cost;
+};
+typedef struct ListingStruct Listing;
+
+/**
+    Checks if a row of a listing is on a page.
+    @param *page the page, or NULL for every row
+    @param row the number of the row, counting from 0
+    @return true if the row is to be printed
+ */
+bool rowOnPage( Page const *page, int row )
+{
+    return page == NULL || (row >= page -> offset && (page -> limit < 0 || row - page -> offset < page -> limit));
+}
+
+/**
+    Returns the number of the first row on a page of a listing.
+    @param *page the page, or NULL for every row
+    @param count the number of rows in the listing
+    @return the first row to print
+ */
+static int pageFirst( Page const *page, int count )
+{
+    if (page == NULL) {
+        return 0;
+    }
+    return page -> offset < count ? page -> offset : count;
+}
+
+/**
+    Returns the number of the row after the last one on a page of a listing.
+    @param *page the page, or NULL for every row
+    @param count the number of rows in the listing
+    @return one past the last row to print
+ */
+static int pageEnd( Page const *page, int count )
 {
-    if (group -> mCount > 0) {
-        qsort(group -> mList, group -> mCount, sizeof(Member *), compare);
+    int first = pageFirst(page, count);
+    if (page == NULL || page -> limit < 0 || page -> limit > count - first) {
+        return count;
     }
+    return first + page -> limit;
 }
 
 /**
-    This function prints all or some of the items.
+    Adds one item's sales to the totals of a listing, and prints its row if the row is on the page. The row is
+    laid out like "%3d %-30s %6d %6d %6d\n", without the cost of parsing a format for every row.
+    @param *listing the listing
+    @param *group the group the item is in
+    @param i the position of the item in the item list
+ */
+static void printItem( Listing *listing, Group const *group, int i )
+{
+    listing -> sold += group -> itemSold[i];
+    listing -> cost += group -> itemRevenue[i];
+    if (!rowOnPage(listing -> page, listing -> row++)) {
+        return;
+    }
+    Output *out = listing -> out;
+    putInt(out, group -> itemIds[i], ITEM_ID_WIDTH);
+    putChar(out, ' ');
+    putLeft(out, group -> itemNamePool + (size_t) i * NAME_SLOT, MAX_NAME_LEN);
+    putChar(out, ' ');
+    putInt(out, group -> itemCosts[i], NUMBER_WIDTH);
+    putChar(out, ' ');
+    putInt(out, group -> itemSold[i], NUMBER_WIDTH);
+    putChar(out, ' ');
+    putInt(out, group -> itemRevenue[i], NUMBER_WIDTH);
+    putChar(out, '\n');
+}
+
+/**
+    Prints the TOTAL line that ends an item listing.
+    @param *listing the listing
+ */
+static void printItemTotal( Listing const *listing )
+{
+    putFormat(listing -> out, "%3s %-30s %6s %4lld %6lld\n\n", "TOTAL", "", "", listing -> sold, listing -> cost);
+}
+
+/**
+    This function prints all or some of the items. Rows and totals come from the running counts kept
+    by recordSale; when test is NULL the TOTAL line is summed from the item columns, and only the rows of
+    the page are visited. The TOTAL line always covers every row that passes the test, not just the page.
     @param *group the pointer to a group to list the items from
-    @param *test is pointer to test function that takes a const *item and char const *str and checks if the *item meets the criteria
+    @param *view the order to list the items in, from makeItemView, or NULL for the order of the item list
+    @param *test is pointer to test function that takes an item's name and char const *str and checks if the name meets the criteria
     @param *str is pointer to a string that we are trying to look for in the item
+    @param *page the rows to print, or NULL for all of them
+    @param *out the output to print to
  */
-void listItems( Group *group, bool (*test)( Item const *item, char const *str ), char const *str ) 
+void listItems( Group *group, int const *view, bool (*test)( char const *name, char const *str ), char const *str,
+                Page const *page, Output *out )
 {
-    int totalItemsSold = 0;
-    int numSold = 0;
-    int total = 0;
-    int totalTable = 0;
-    for (int i = 0; i < group -> iCount; i++) {
-        Item *item = group -> iList[i];
-        if (test != NULL && !test(item, str)) {
-            continue;
+    Listing listing = { out, page, 0, 0, 0 };
+    if (test == NULL) {
+        listing.row = pageFirst(page, group -> iCount);
+        int end = pageEnd(page, group -> iCount);
+        for (int i = listing.row; i < end; i++) {
+            printItem(&listing, group, view == NULL ? i : view[i]);
+        }
+        listing.sold = sumColumn(group -> itemSold, group -> iCount);
+        listing.cost = sumColumn(group -> itemRevenue, group -> iCount);
+    }
+    else {
+        for (int i = 0; i < group -> iCount; i++) {
+            int pos = view == NULL ? i : view[i];
+            if (test(itemName(group, pos), str)) {
+                printItem(&listing, group, pos);
+            }
         }
-        numSold = item -> numSold;
-        total = item -> cost * numSold;
-        printf("%3d %-30s %6d %6d %6d\n", item -> itemId, item -> nameOfItem, item -> cost, numSold, total);
-        totalItemsSold += numSold;
-        totalTable += total;
+    }
+    printItemTotal(&listing);
+}
 
+/**
+    Adds one member's sales to the totals of a listing, and prints its row if the row is on the page. The row
+    is laid out like "%-8s %-30s %6d %6d\n".
+    @param *listing the listing
+    @param *m the member
+ */
+static void printMember( Listing *listing, Member const *m )
+{
+    listing -> sold += m -> totalSold;
+    listing -> cost += m -> revenue;
+    if (!rowOnPage(listing -> page, listing -> row++)) {
+        return;
     }
-    printf("%3s %-30s %6s %4d %6d\n\n", "TOTAL", "", "", totalItemsSold, totalTable);
+    Output *out = listing -> out;
+    putLeft(out, m -> memberId, MAX_ID_LEN);
+    putChar(out, ' ');
+    putLeft(out, m -> name, MAX_NAME_LEN);
+    putChar(out, ' ');
+    putInt(out, m -> totalSold, NUMBER_WIDTH);
+    putChar(out, ' ');
+    putInt(out, m -> revenue, NUMBER_WIDTH);
+    putChar(out, '\n');
+}
+
+/**
+    Prints the TOTAL line that ends a member listing.
+    @param *listing the listing
+ */
+static void printMemberTotal( Listing const *listing )
+{
+    putFormat(listing -> out, "%-8s %-30s %6lld %6lld\n\n", "TOTAL", "", listing -> sold, listing -> cost);
 }
 
 /**
-    This function prints all or some of the members.
+    This function prints all or some of the members. Rows and totals come from the running counts kept
+    by recordSale; when test is NULL the TOTAL line is summed from the item columns, and only the rows of
+    the page are visited. The TOTAL line always covers every row that passes the test, not just the page.
     @param *group the pointer to a group to list the members from
+    @param *view the order to list the members in, from makeMemberView, or NULL for the order of the member list
     @param *test is pointer to test function that takes a const *member and char const *str and checks if the *item meets the criteria
     @param *str is pointer to a string that we are trying to look for in the *member
+    @param *page the rows to print, or NULL for all of them
+    @param *out the output to print to
+ */
+void listMembers( Group *group, int const *view, bool (*test)( Member const *member, char const *str ),
+                  char const *str, Page const *page, Output *out )
+{
+    Listing listing = { out, page, 0, 0, 0 };
+    if (test == NULL) {
+        listing.row = pageFirst(page, group -> mCount);
+        int end = pageEnd(page, group -> mCount);
+        for (int i = listing.row; i < end; i++) {
+            printMember(&listing, group -> mList[view == NULL ? i : view[i]]);
+        }
+        // every sale is counted once by its item and once by its member, so the item columns give the total
+        listing.sold = sumColumn(group -> itemSold, group -> iCount);
+        listing.cost = sumColumn(group -> itemRevenue, group -> iCount);
+    }
+    else {
+        for (int i = 0; i < group -> mCount; i++) {
+            Member *m = group -> mList[view == NULL ? i : view[i]];
+            if (test(m, str)) {
+                printMember(&listing, m);
+            }
+        }
+    }
+    printMemberTotal(&listing);
+}
+
+/**
+    Adds a member's row to a top seller listing.
+    @param *m the member to print
+    @param *data points to the Listing
  */
-void listMembers( Group *group, bool (*test)( Member const *member, char const *str ), char const *str ) 
+static void printSeller( Member *m, void *data )
 {
-    
-    int totalItemsSold = 0;
-    int totalCost = 0;
+    printMember(data, m);
+}
+
+/**
+    This function prints the members ranked by the revenue from their sales, highest first, with ties
+    in member id order. The ranking is kept up to date by recordSale, so nothing is sorted here and
+    the order of the member list is left alone. A listing of every member is only walked to the end of
+    the page, since its TOTAL line comes from the item columns.
+    @param *group the pointer to a group to list the top sellers from
+    @param limit the most members to list, or a negative number to list all of them
+    @param *page the rows of the listing to print, or NULL for all of them
+    @param *out the output to print to
+ */
+void listTopSellers( Group *group, int limit, Page const *page, Output *out )
+{
+    Listing listing = { out, page, 0, 0, 0 };
+    forEachSeller(&group -> sellers, limit < 0 ? pageEnd(page, group -> mCount) : limit, printSeller, &listing);
+    if (limit < 0) {
+        listing.sold = sumColumn(group -> itemSold, group -> iCount);
+        listing.cost = sumColumn(group -> itemRevenue, group -> iCount);
+    }
+    printMemberTotal(&listing);
+}
+
+/**
+    This function prints the sales of one member, one row for each item the member sold, and the member's
+    totals. The sales are kept sorted by position in the item list, which is item id order, so the rows come
+    out in one pass over them with nothing to sort or merge. The row is laid out like "%-3d %-30s %6d %6d %6d\n".
+    @param *group the pointer to the group the member is in
+    @param *m the member whose sales are listed
+    @param *page the rows to print, or NULL for all of them; the TOTAL line always covers every sale
+    @param *out the output to print to
+ */
+void listMemberSales( Group const *group, Member const *m, Page const *page, Output *out )
+{
+    int end = pageEnd(page, m -> soldItemCount);
+    for (int i = pageFirst(page, m -> soldItemCount); i < end; i++) {
+        int itemIndex = m -> soldItems[i].itemIndex;
+        int sold = m -> soldItems[i].quantity;
+        putIntLeft(out, group -> itemIds[itemIndex], ITEM_ID_WIDTH);
+        putChar(out, ' ');
+        putLeft(out, itemName(group, itemIndex), MAX_NAME_LEN);
+        putChar(out, ' ');
+        putInt(out, group -> itemCosts[itemIndex], NUMBER_WIDTH);
+        putChar(out, ' ');
+        putInt(out, sold, NUMBER_WIDTH);
+        putChar(out, ' ');
+        putInt(out, sold * group -> itemCosts[itemIndex], NUMBER_WIDTH);
+        putChar(out, '\n');
+    }
+    putFormat(out, "%3s %-30s %6s %4d %6d\n\n", "TOTAL", "", "", m -> totalSold, m -> revenue);
+}
+
+/**
+    Builds the trigram indexes of the item and member names, so searches only check names that can match. The
+    same is done for lowercase copies of the names, kept in pools for searches that ignore case. The lists must
+    not be reordered after this.
+    @param *group the pointer to the group to index
+ */
+void indexNames( Group *group )
+{
+    int most = group -> iCount > group -> mCount ? group -> iCount : group -> mCount;
+    char const **names = (char const **)malloc((most + 1) * sizeof(char const *));
+    if (names == NULL) {
+        fprintf(stderr, "Memory allocation issue.\n");
+        exit(EXIT_FAILURE);
+    }
+    for (int i = 0; i < group -> iCount; i++) {
+        names[i] = itemName(group, i);
+    }
+    buildTrigramIndex(&group -> itemNames, names, group -> iCount);
+    group -> itemsFolded = makeFoldedPool(names, group -> iCount);
+    for (int i = 0; i < group -> iCount; i++) {
+        names[i] = group -> itemsFolded + (size_t) i * FOLD_SLOT;
+    }
+    buildTrigramIndex(&group -> foldedItemNames, names, group -> iCount);
+    for (int i = 0; i < group -> mCount; i++) {
+        names[i] = group -> mList[i] -> name;
+    }
+    buildTrigramIndex(&group -> memberNames, names, group -> mCount);
+    group -> membersFolded = makeFoldedPool(names, group -> mCount);
     for (int i = 0; i < group -> mCount; i++) {
-        Member *m = group -> mList[i];
-        if (test != NULL && !test(m, str)) {
-            continue;
+        names[i] = group -> membersFolded + (size_t) i * FOLD_SLOT;
+    }
+    buildTrigramIndex(&group -> foldedMemberNames, names, group -> mCount);
+    free(names);
+}
+
+/**
+    This function prints the items whose names pass the test for a search string, in item list order. Names
+    that can't contain the string are ruled out with the trigram index first, so only the remaining candidates
+    are tested. Strings too short for the index are tested against every item.
+    @param *group the pointer to a group to search the items of
+    @param *test is pointer to a test function that checks if an item's name contains str
+    @param *str is pointer to the string to search for
+    @param *page the matching rows to print, or NULL for all of them
+    @param *out the output to print to
+ */
+void searchItems( Group *group, bool (*test)( char const *name, char const *str ), char const *str,
+                  Page const *page, Output *out )
+{
+    if (strlen(str) < TRIGRAM_LEN) {
+        listItems(group, NULL, test, str, page, out);
+        return;
+    }
+    int *candidates;
+    int count = findCandidates(&group -> itemNames, str, &candidates);
+    Listing listing = { out, page, 0, 0, 0 };
+    for (int i = 0; i < count; i++) {
+        if (test(itemName(group, candidates[i]), str)) {
+            printItem(&listing, group, candidates[i]);
         }
-        int soldItems = 0;
-        int totalMemberCost = 0;
+    }
+    free(candidates);
+    printItemTotal(&listing);
+}
 
-        for (int j = 0; j < m -> soldItemCount; j++) {
-            SaleItem *s = m -> soldItems[j];
-            soldItems += s -> quantity;
-            totalMemberCost += s -> quantity * s -> item -> cost;
+/**
+    This function prints the members whose names pass the test for a search string, in member list order.
+    Names that can't contain the string are ruled out with the trigram index first, so only the remaining
+    candidates are tested. Strings too short for the index are tested against every member.
+    @param *group the pointer to a group to search the members of
+    @param *test is pointer to a test function that checks if a member's name contains str
+    @param *str is pointer to the string to search for
+    @param *page the matching rows to print, or NULL for all of them
+    @param *out the output to print to
+ */
+void searchMembers( Group *group, bool (*test)( Member const *member, char const *str ), char const *str,
+                    Page const *page, Output *out )
+{
+    if (strlen(str) < TRIGRAM_LEN) {
+        listMembers(group, NULL, test, str, page, out);
+        return;
+    }
+    int *candidates;
+    int count = findCandidates(&group -> memberNames, str, &candidates);
+    Listing listing = { out, page, 0, 0, 0 };
+    for (int i = 0; i < count; i++) {
+        Member *m = group -> mList[candidates[i]];
+        if (test(m, str)) {
+            printMember(&listing, m);
+        }
+    }
+    free(candidates);
+    printMemberTotal(&listing);
+}
+
+/**
+    This function prints the items whose names contain a search string, ignoring case, in item list order. It
+    works like searchItems on the lowercase copies of the names made by indexNames, so no name is folded during
+    the search.
+    @param *group the pointer to a group to search the items of
+    @param *str is pointer to the string to search for
+    @param *page the matching rows to print, or NULL for all of them
+    @param *out the output to print to
+ */
+void searchItemsIgnoreCase( Group *group, char const *str, Page const *page, Output *out )
+{
+    char folded[FOLD_SLOT];
+    int len = foldString(folded, str);
+    Listing listing = { out, page, 0, 0, 0 };
+    if (len < TRIGRAM_LEN) {
+        for (int i = 0; i < group -> iCount; i++) {
+            if (foldedContains(group -> itemsFolded + (size_t) i * FOLD_SLOT, folded, len)) {
+                printItem(&listing, group, i);
+            }
+        }
+    }
+    else {
+        int *candidates;
+        int count = findCandidates(&group -> foldedItemNames, folded, &candidates);
+        for (int i = 0; i < count; i++) {
+            if (foldedContains(group -> itemsFolded + (size_t) candidates[i] * FOLD_SLOT, folded, len)) {
+                printItem(&listing, group, candidates[i]);
+            }
         }
-        printf("%-8s %-30s %6d %6d\n", m -> memberId, m -> name, soldItems, totalMemberCost);
+        free(candidates);
+    }
+    printItemTotal(&listing);
+}
 
-        totalItemsSold += soldItems;
-        totalCost += totalMemberCost;
+/**
+    This function prints the members whose names contain a search string, ignoring case, in member list order.
+    It works like searchMembers on the lowercase copies of the names made by indexNames, so no name is folded
+    during the search.
+    @param *group the pointer to a group to search the members of
+    @param *str is pointer to the string to search for
+    @param *page the matching rows to print, or NULL for all of them
+    @param *out the output to print to
+ */
+void searchMembersIgnoreCase( Group *group, char const *str, Page const *page, Output *out )
+{
+    char folded[FOLD_SLOT];
+    int len = foldString(folded, str);
+    Listing listing = { out, page, 0, 0, 0 };
+    if (len < TRIGRAM_LEN) {
+        for (int i = 0; i < group -> mCount; i++) {
+            if (foldedContains(group -> membersFolded + (size_t) i * FOLD_SLOT, folded, len)) {
+                printMember(&listing, group -> mList[i]);
+            }
+        }
+    }
+    else {
+        int *candidates;
+        int count = findCandidates(&group -> foldedMemberNames, folded, &candidates);
+        for (int i = 0; i < count; i++) {
+            if (foldedContains(group -> membersFolded + (size_t) candidates[i] * FOLD_SLOT, folded, len)) {
+                printMember(&listing, group -> mList[candidates[i]]);
+            }
+        }
+        free(candidates);
+    }
+    printMemberTotal(&listing);
+}
 
+/**
+    Records that a member sold some number of an item, updating the item, the member's sales and
+    the top seller ranking. The member's sales are kept in item list order, so the entry for the item
+    is found with a binary search and a new entry is slid into place. If the group has a journal, the
+    sale is added to it. If the group keeps views, the item and the member are copied first when a view may
+    be reading them.
+    @param *group the pointer to the group the sale is made in
+    @param *m the member who made the sale
+    @param itemIndex the position of the item that was sold in the item list
+    @param quantity how many of the item were sold
+ */
+void recordSale( Group *group, Member *m, int itemIndex, int quantity )
+{
+    if (group -> versions != NULL) {
+        m = writableMember(group, m);
+        itemChanging(group, itemIndex);
     }
-    printf("%-8s %-30s %6d %6d\n\n", "TOTAL", "", totalItemsSold, totalCost);
+    int cost = group -> itemCosts[itemIndex];
+    int amount = quantity * cost;
+    group -> itemSold[itemIndex] += quantity;
+    group -> itemRevenue[itemIndex] += (long long) quantity * cost;
+    m -> totalSold += quantity;
+    m -> revenue += amount;
 
+    // Find where the item is, or belongs, in the member's sales
+    int lo = 0;
+    int hi = m -> soldItemCount;
+    while (lo < hi) {
+        int mid = (lo + hi) / DOUBLE_SIZE;
+        if (m -> soldItems[mid].itemIndex < itemIndex) {
+            lo = mid + 1;
+        }
+        else {
+            hi = mid;
+        }
+    }
+    if (lo < m -> soldItemCount && m -> soldItems[lo].itemIndex == itemIndex) {
+        m -> soldItems[lo].quantity += quantity;
+    }
+    else {
+        if (m -> soldItemCount == m -> soldItemCap) {
+            // sales lists are power-of-two blocks from the arena, and outgrown ones are reused by other members
+            int newCap = m -> soldItemCap == 0 ? INITIAL_SALES : m -> soldItemCap * DOUBLE_SIZE;
+            SaleItem *newSales = (SaleItem *)arenaBlock(&group -> arena, newCap * sizeof(SaleItem));
+            if (m -> soldItemCount > 0) {
+                memcpy(newSales, m -> soldItems, m -> soldItemCount * sizeof(SaleItem));
+                arenaRelease(&group -> arena, m -> soldItems, m -> soldItemCap * sizeof(SaleItem));
+            }
+            m -> soldItems = newSales;
+            m -> soldItemCap = newCap;
+        }
+        memmove(m -> soldItems + lo + 1, m -> soldItems + lo, (m -> soldItemCount - lo) * sizeof(SaleItem));
+        m -> soldItems[lo].itemIndex = itemIndex;
+        m -> soldItems[lo].quantity = quantity;
+        m -> soldItemCount++;
+    }
+    addRevenue(&group -> sellers, m -> boardSlot, amount);
+    if (group -> journal != NULL) {
+        appendSale(group -> journal, m -> memberId, group -> itemIds[itemIndex], quantity);
+        group -> journalRecords++;
+    }
+}
+
+/**
+    Makes a sale the way the sale command does: the member and the item are looked up by id, and the
+    sale is recorded if both are found. A sale of an unknown item by a known member changes nothing.
+    @param *group the pointer to the group the sale is made in
+    @param *memberId the id of the member who made the sale
+    @param itemId the id of the item that was sold
+    @param quantity how many of the item were sold
+    @return SALE_RECORDED, SALE_IGNORED if there's no such item or SALE_INVALID if there's no such member
+ */
+int sellItem( Group *group, char const *memberId, int itemId, int quantity )
+{
+    Member *m = findMember(group, memberId);
+    if (m == NULL) {
+        return SALE_INVALID;
+    }
+    int itemIndex = findItemIndex(group, itemId);
+    if (itemIndex < 0) {
+        return SALE_IGNORED;
+    }
+    recordSale(group, m, itemIndex, quantity);
+    return SALE_RECORDED;
+}
+
+/**
+    Looks up the position of an item in the item list by its id, using the group's item hash index.
+    @param *group the pointer to a group to look the item up in
+    @param itemId the id of the item to find
+    @return the position of the item with the given id, or -1 if there isn't one
+ */
+int findItemIndex( Group const *group, int itemId )
+{
+    unsigned int mask = group -> iTableCap - 1;
+    unsigned int slot = hashItemId(itemId) & mask;
+    while (group -> iTable[slot] != EMPTY_SLOT) {
+        if (group -> itemIds[group -> iTable[slot]] == itemId) {
+            return group -> iTable[slot];
+        }
+        slot = (slot + 1) & mask;
+    }
+    return EMPTY_SLOT;
+}
+
+/**
+    Packs a member id into a number, its characters from the most significant byte down and zeros after
+    the end, so packed ids compare the way strcmp compares the ids.
+    @param *memberId the id, at most MAX_ID_LEN characters
+    @return the packed id
+ */
+unsigned long long packMemberId( char const *memberId )
+{
+    unsigned long long idKey = 0;
+    for (int i = 0; i < MAX_ID_LEN; i++) {
+        unsigned char c = 0;
+        if (*memberId != '\0') {
+            c = (unsigned char) *memberId++;
+        }
+        idKey = idKey << BYTE_BITS | c;
+    }
+    return idKey;
+}
+
+/**
+    Looks up the position of a member in the member list by its id, using the group's member hash index.
+    @param *group the pointer to a group to look the member up in
+    @param *memberId the id of the member to find
+    @return the position of the member with the given id, or -1 if there isn't one
+ */
+int findMemberIndex( Group const *group, char const *memberId )
+{
+    // a packed id only holds MAX_ID_LEN characters, and no member has a longer id
+    if (strlen(memberId) > MAX_ID_LEN) {
+        return EMPTY_SLOT;
+    }
+    unsigned long long idKey = packMemberId(memberId);
+    unsigned int mask = group -> mTableCap - 1;
+    unsigned int slot = hashMemberId(idKey) & mask;
+    while (group -> mTable[slot] != EMPTY_SLOT) {
+        if (group -> mList[group -> mTable[slot]] -> idKey == idKey) {
+            return group -> mTable[slot];
+        }
+        slot = (slot + 1) & mask;
+    }
+    return EMPTY_SLOT;
+}
+
+/**
+    Returns the name of an item from the item name pool.
+    @param *group the pointer to the group the item is in
+    @param itemIndex the position of the item in the item list
+    @return the name
+ */
+char const *itemName( Group const *group, int itemIndex )
+{
+    return group -> itemNamePool + (size_t) itemIndex * NAME_SLOT;
+}
+
+/**
+    Looks up a member by its id using the group's member hash index.
+    @param *group the pointer to a group to look the member up in
+    @param *memberId the id of the member to find
+    @return a pointer to the member with the given id, or NULL if there isn't one
+ */
+Member *findMember( Group const *group, char const *memberId )
+{
+    int pos = findMemberIndex(group, memberId);
+    return pos == EMPTY_SLOT ? NULL : group -> mList[pos];
 }
@@ -8,6 +8,14 @@
 #include <stdbool.h>
 #include <string.h>
 #include <ctype.h>
+#include "leaderboard.h"
+#include "arena.h"
+#include "trigram.h"
+#include "fold.h"
+#include "output.h"
+#include "journal.h"
+#include "view.h"
+#include "column.h"
 
 /** Initial size for the member and sale item representation */
 #define INITIAL_SIZE 5
@@ -15,43 +23,105 @@
 #define MAX_NAME_LEN 30
 /** Maximum length for an ID */
 #define MAX_ID_LEN 8
+/** Bytes each name takes in the item name pool, enough for a name, its null terminator and padding */
+#define NAME_SLOT 32
 /** Multiply by 2 to increase array size during resizing */
 #define DOUBLE_SIZE 2
+/** Number of entries in a member's sales list when it is first allocated, must be a power of two */
+#define INITIAL_SALES 4
+/** Initial number of slots in the member and item hash indexes, must be a power of two */
+#define INITIAL_TABLE_SIZE 16
+/** sellItem found no member with the id, so the sale is invalid */
+#define SALE_INVALID -1
+/** sellItem found the member but no item with the id, so nothing changed */
+#define SALE_IGNORED 0
+/** sellItem recorded the sale */
+#define SALE_RECORDED 1
+/** parseItems or parseMembers read the whole file */
+#define FILE_READ 0
+/** parseItems or parseMembers couldn't open the file */
+#define FILE_MISSING 1
+/** parseItems or parseMembers found a line that isn't valid */
+#define FILE_INVALID 2
 
-/** Struct for the items */
-struct ItemStruct {
+/** Struct for what an item comparison function sees of an item, for makeItemView */
+struct ItemKeyStruct {
     int itemId;
-    char nameOfItem[MAX_NAME_LEN + 1];
-    int cost;
-    int numSold;
+    char const *name;
+    int index;
 };
-typedef struct ItemStruct Item;
+typedef struct ItemKeyStruct ItemKey;
 
-/** Struct for the helping us deal with how many of each item are sold */
+/**
+    Struct for the rows of a listing to print: the first offset rows are skipped, then at most limit rows
+    are printed, or all of the rest when limit is negative
+ */
+struct PageStruct {
+    int offset;
+    int limit;
+};
+typedef struct PageStruct Page;
+
+/** Page limit that prints every row after the offset */
+#define ALL_ROWS -1
+
+/** Struct for the helping us deal with how many of each item are sold, by the item's position in the item list */
 struct SaleItemStruct {
-    Item *item;  
+    int itemIndex;
     int quantity;
 };
 typedef struct SaleItemStruct SaleItem;
 
-/** Struct for the members */
+/** Struct for the members. idKey is the id packed by packMemberId, so ids compare and hash as one number */
 struct MemberStruct {
     char memberId[MAX_ID_LEN + 1];
     char name[MAX_NAME_LEN + 1];
-    SaleItem **soldItems;
+    unsigned long long idKey;
+    SaleItem *soldItems;
     int soldItemCount; 
     int soldItemCap;     
+    int boardSlot;
+    int totalSold;
+    int revenue;
 };
 typedef struct MemberStruct Member;
 
-/** Struct for the group */
+/**
+    Struct for the group. The items are kept as columns, one array for each field, so a scan of one field
+    reads nothing else; item i's name is at itemNamePool + i * NAME_SLOT.
+ */
 struct GroupStruct {
     int iCount;
-    Item **iList;
     int iCap;
+    int *itemIds;
+    int *itemCosts;
+    long long *itemSold;
+    long long *itemRevenue;
+    char *itemNamePool;
     int mCount;
     Member **mList;
     int mCap;
+    int *iTable;
+    int iTableCap;
+    int *mTable;
+    int mTableCap;
+    Leaderboard sellers;
+    int *itemsByName;
+    int *membersByName;
+    Arena arena;
+    TrigramIndex itemNames;
+    TrigramIndex memberNames;
+    char *itemsFolded;
+    char *membersFolded;
+    TrigramIndex foldedItemNames;
+    TrigramIndex foldedMemberNames;
+    char const *snapshot;
+    size_t snapshotSize;
+    bool snapshotRead;
+    Journal *journal;
+    unsigned long long journalId;
+    long long journalRecords;
+    Versions *versions;
 };
 typedef struct GroupStruct Group;
 /**
@@ -61,51 +131,259 @@ typedef struct GroupStruct Group;
  */
 Group *makeGroup();
 /**
-    Function frees the memory used to store the given Group, including freeing space for all the Items, 
+    Function frees the memory used to store the given Group, including freeing the item columns, the
     Members, and Member SaleItem lists, freeing the resizable arrays of pointers and freeing space for the Group struct 
-    itself.
+    itself. The Members and SaleItem lists all live in the group's arena, so they go with a handful of
+    chunk frees. A group loaded from a snapshot keeps its records, indexes and name orders in the mapped
+    snapshot file, so those go when the file is unmapped; only what a reload has replaced since is freed.
     @param *group the group to free, or empty the allocated memory of
  */
 void freeGroup( Group *group );
 /**
-    Function reads all the items from an item file with the given name. It makes an instance 
-    of the Item struct for an item in the file and stores a pointer to that Item in the resizable item array in group.
+    Checks if some storage of a group lies in the snapshot file the group was loaded from.
+    @param *group the group
+    @param *storage the storage
+    @return true if the storage is part of the mapped snapshot, and goes when it is unmapped
+ */
+bool inSnapshot( Group const *group, void const *storage );
+/**
+    Reads all the items from an item file into the end of a group's item columns, which are resized as needed.
+    The file is mapped into memory and each line is parsed in place, accepting exactly what
+    sscanf(line, "%d %d %30[^\n]") would: an id, a cost and the rest of the line, cut to 30 characters, as the name.
+    Nothing is reported, so the caller decides what a bad file means.
+    @param *filename the pointer to a file to read in
+    @param *group the group to add the items to
+    @return FILE_READ, FILE_MISSING if the file couldn't be opened or FILE_INVALID if a line is invalid
+ */
+int parseItems( char const *filename, Group *group );
+/**
+    Function reads all the items from an item file with the given name. Each item in the file is added
+    to the end of the group's item columns, which are resized as needed. The file is parsed by parseItems, and
+    the program exits if it can't be opened or isn't valid.
     @param *filename the pointer to a file to read in
     @param *group allows us to access the actual group variable or object that is being pointed at
  */
 void readItems( char const *filename, Group *group );
 /**
-    Function sorts the items in the given group. It uses the qsort() function together with the function 
-    pointer parameter to order the items.
+    Reads all the members from a member file into a group. It makes an instance of the Member struct for each
+    line of the file and stores a pointer to it in the resizable member array in group.
+    The file is mapped into memory and each line is parsed in place, accepting exactly what
+    sscanf(line, "%8s %[^\n]") would: up to 8 non-blank characters as the id and the rest of the line as the name.
+    Nothing is reported, so the caller decides what a bad file means.
+    @param *filename the pointer to a file to read in
+    @param *group the group to add the members to
+    @return FILE_READ, FILE_MISSING if the file couldn't be opened or FILE_INVALID if a line is invalid
+ */
+int parseMembers( char const *filename, Group *group );
+/**
+    Function reads all the members from a member file with the given name. It makes an instance of the Member
+    struct for each line of the file and stores a pointer to it in the resizable member array in group. The file
+    is parsed by parseMembers, and the program exits if it can't be opened or isn't valid.
     @param *filename the pointer to a file to read in
     @param *group allows us to access the actual group variable or object that is being pointed at
  */
 void readMembers( char const *filename, Group *group );
 /**
-    Function sorts the items in the given group. It uses the qsort() function together with 
-    the function pointer parameter to order the items.
+    Sorts the items in the given group by id, with a radix sort of the ids. The item index is rebuilt for the
+    new order.
     @param *group the pointer to a group to sort the items in
-    @param *compare is a pointer to a comparison function to help us sort items
  */
-void sortItems( Group *group, int (* compare) (void const *va, void const *vb ));
+void sortItemsById( Group *group );
 /**
-    This function sorts the members in the given group. It uses the qsort() function together with the 
-    function pointer parameter to order the members.
+    Sorts the members in the given group by id, with a radix sort of the packed ids. The member index is
+    rebuilt for the new order.
     @param *group the pointer to a group to sort the members in
-    @param *compare is a pointer to a comparison function to help us sort members
  */
-void sortMembers( Group *group, int (* compare) (void const *va, void const *vb ));
+void sortMembersById( Group *group );
+/**
+    Checks if two item names are equal
+    @param *va a pointer to an item name that we are currently looking at
+    @param *vb a pointer to an item name to compare with
+    @return 0 if *va is equal to *vb else returns false
+ */
+int compareItemsByName(const void *va, const void *vb);
+/**
+    Checks if two member names are equal
+    @param *va a pointer to a member name that we are currently looking at
+    @param *vb a pointer to a member name to compare with
+    @return 0 if *va is equal to *vb else returns false
+ */
+int compareMembersByName(const void *va, const void *vb);
+/**
+    Builds a view of the items: the positions in the item list, in the order given by the comparison function.
+    The item list must not be reordered while the view is in use.
+    @param *group the pointer to a group to build the view of
+    @param *compare is a pointer to a comparison function for ItemKeys, as used with qsort
+    @return a dynamically allocated array of iCount positions in the item list
+ */
+int *makeItemView( Group const *group, int (* compare) (void const *va, void const *vb ));
 /**
-    This function prints all or some of the items.
+    Builds a view of the members: the positions in the member list, in the order given by the comparison function.
+    The member list must not be reordered while the view is in use.
+    @param *group the pointer to a group to build the view of
+    @param *compare is a pointer to a comparison function for pointers to members, as used with qsort
+    @return a dynamically allocated array of mCount positions in the member list
+ */
+int *makeMemberView( Group const *group, int (* compare) (void const *va, void const *vb ));
+/**
+    Checks if a row of a listing is on a page.
+    @param *page the page, or NULL for every row
+    @param row the number of the row, counting from 0
+    @return true if the row is to be printed
+ */
+bool rowOnPage( Page const *page, int row );
+/**
+    This function prints all or some of the items. Rows and totals come from the running counts kept
+    by recordSale; when test is NULL the TOTAL line is summed from the item columns, and only the rows of
+    the page are visited. The TOTAL line always covers every row that passes the test, not just the page.
     @param *group the pointer to a group to list the items from
-    @param *test is pointer to test function that takes a const *item and char const *str and checks if the *item meets the criteria
+    @param *view the order to list the items in, from makeItemView, or NULL for the order of the item list
+    @param *test is pointer to test function that takes an item's name and char const *str and checks if the name meets the criteria
     @param *str is pointer to a string that we are trying to look for in the item
+    @param *page the rows to print, or NULL for all of them
+    @param *out the output to print to
  */
-void listItems( Group *group, bool (*test)( Item const *item, char const *str ), char const *str );
+void listItems( Group *group, int const *view, bool (*test)( char const *name, char const *str ), char const *str,
+                Page const *page, Output *out );
 /**
-    This function prints all or some of the members.
+    This function prints all or some of the members. Rows and totals come from the running counts kept
+    by recordSale; when test is NULL the TOTAL line is summed from the item columns, and only the rows of
+    the page are visited. The TOTAL line always covers every row that passes the test, not just the page.
     @param *group the pointer to a group to list the members from
+    @param *view the order to list the members in, from makeMemberView, or NULL for the order of the member list
     @param *test is pointer to test function that takes a const *member and char const *str and checks if the *item meets the criteria
     @param *str is pointer to a string that we are trying to look for in the *member
+    @param *page the rows to print, or NULL for all of them
+    @param *out the output to print to
+ */
+void listMembers( Group *group, int const *view, bool (*test)( Member const *member, char const *str ),
+                  char const *str, Page const *page, Output *out );
+/**
+    This function prints the members ranked by the revenue from their sales, highest first, with ties
+    in member id order. The ranking is kept up to date by recordSale, so nothing is sorted here and
+    the order of the member list is left alone. A listing of every member is only walked to the end of
+    the page, since its TOTAL line comes from the item columns.
+    @param *group the pointer to a group to list the top sellers from
+    @param limit the most members to list, or a negative number to list all of them
+    @param *page the rows of the listing to print, or NULL for all of them
+    @param *out the output to print to
+ */
+void listTopSellers( Group *group, int limit, Page const *page, Output *out );
+/**
+    This function prints the sales of one member, one row for each item the member sold, and the member's
+    totals. The sales are kept sorted by position in the item list, which is item id order, so the rows come
+    out in one pass over them with nothing to sort or merge. The row is laid out like "%-3d %-30s %6d %6d %6d\n".
+    @param *group the pointer to the group the member is in
+    @param *m the member whose sales are listed
+    @param *page the rows to print, or NULL for all of them; the TOTAL line always covers every sale
+    @param *out the output to print to
+ */
+void listMemberSales( Group const *group, Member const *m, Page const *page, Output *out );
+/**
+    Builds the trigram indexes of the item and member names, so searches only check names that can match. The
+    same is done for lowercase copies of the names, kept in pools for searches that ignore case. The lists must
+    not be reordered after this.
+    @param *group the pointer to the group to index
+ */
+void indexNames( Group *group );
+/**
+    This function prints the items whose names pass the test for a search string, in item list order. Names
+    that can't contain the string are ruled out with the trigram index first, so only the remaining candidates
+    are tested. Strings too short for the index are tested against every item.
+    @param *group the pointer to a group to search the items of
+    @param *test is pointer to a test function that checks if an item's name contains str
+    @param *str is pointer to the string to search for
+    @param *page the matching rows to print, or NULL for all of them
+    @param *out the output to print to
+ */
+void searchItems( Group *group, bool (*test)( char const *name, char const *str ), char const *str,
+                  Page const *page, Output *out );
+/**
+    This function prints the members whose names pass the test for a search string, in member list order.
+    Names that can't contain the string are ruled out with the trigram index first, so only the remaining
+    candidates are tested. Strings too short for the index are tested against every member.
+    @param *group the pointer to a group to search the members of
+    @param *test is pointer to a test function that checks if a member's name contains str
+    @param *str is pointer to the string to search for
+    @param *page the matching rows to print, or NULL for all of them
+    @param *out the output to print to
+ */
+void searchMembers( Group *group, bool (*test)( Member const *member, char const *str ), char const *str,
+                    Page const *page, Output *out );
+/**
+    This function prints the items whose names contain a search string, ignoring case, in item list order. It
+    works like searchItems on the lowercase copies of the names made by indexNames, so no name is folded during
+    the search.
+    @param *group the pointer to a group to search the items of
+    @param *str is pointer to the string to search for
+    @param *page the matching rows to print, or NULL for all of them
+    @param *out the output to print to
+ */
+void searchItemsIgnoreCase( Group *group, char const *str, Page const *page, Output *out );
+/**
+    This function prints the members whose names contain a search string, ignoring case, in member list order.
+    It works like searchMembers on the lowercase copies of the names made by indexNames, so no name is folded
+    during the search.
+    @param *group the pointer to a group to search the members of
+    @param *str is pointer to the string to search for
+    @param *page the matching rows to print, or NULL for all of them
+    @param *out the output to print to
+ */
+void searchMembersIgnoreCase( Group *group, char const *str, Page const *page, Output *out );
+/**
+    Records that a member sold some number of an item, updating the item, the member's sales and
+    the top seller ranking. The member's sales are kept in item list order, so the entry for the item
+    is found with a binary search and a new entry is slid into place. If the group has a journal, the
+    sale is added to it. If the group keeps views, the item and the member are copied first when a view may
+    be reading them.
+    @param *group the pointer to the group the sale is made in
+    @param *m the member who made the sale
+    @param itemIndex the position of the item that was sold in the item list
+    @param quantity how many of the item were sold
+ */
+void recordSale( Group *group, Member *m, int itemIndex, int quantity );
+/**
+    Makes a sale the way the sale command does: the member and the item are looked up by id, and the
+    sale is recorded if both are found. A sale of an unknown item by a known member changes nothing.
+    @param *group the pointer to the group the sale is made in
+    @param *memberId the id of the member who made the sale
+    @param itemId the id of the item that was sold
+    @param quantity how many of the item were sold
+    @return SALE_RECORDED, SALE_IGNORED if there's no such item or SALE_INVALID if there's no such member
+ */
+int sellItem( Group *group, char const *memberId, int itemId, int quantity );
+/**
+    Looks up the position of an item in the item list by its id, using the group's item hash index.
+    @param *group the pointer to a group to look the item up in
+    @param itemId the id of the item to find
+    @return the position of the item with the given id, or -1 if there isn't one
+ */
+int findItemIndex( Group const *group, int itemId );
+/**
+    Packs a member id into a number, its characters from the most significant byte down and zeros after
+    the end, so packed ids compare the way strcmp compares the ids.
+    @param *memberId the id, at most MAX_ID_LEN characters
+    @return the packed id
+ */
+unsigned long long packMemberId( char const *memberId );
+/**
+    Looks up the position of a member in the member list by its id, using the group's member hash index.
+    @param *group the pointer to a group to look the member up in
+    @param *memberId the id of the member to find
+    @return the position of the member with the given id, or -1 if there isn't one
+ */
+int findMemberIndex( Group const *group, char const *memberId );
+/**
+    Returns the name of an item from the item name pool.
+    @param *group the pointer to the group the item is in
+    @param itemIndex the position of the item in the item list
+    @return the name
+ */
+char const *itemName( Group const *group, int itemIndex );
+/**
+    Looks up a member by its id using the group's member hash index.
+    @param *group the pointer to a group to look the member up in
+    @param *memberId the id of the member to find
+    @return a pointer to the member with the given id, or NULL if there isn't one
  */
-void listMembers( Group *group, bool (*test)( Member const *member, char const *str ), char const *str );
+Member *findMember( Group const *group, char const *memberId );
@@ -1,9 +1,10 @@
 /**
     @file input.c
     @author Sachi Vyas (smvyas)
-    A program that: Helps us reads a single line of input from the given input stream (stdin or a file) and returns it as a 
-    string inside a block of dynamically allocated memory.
+    A program that: Helps us read input: maps whole files into memory to be parsed in place, and reads lines of
+    commands from a file descriptor through a reused buffer.
  */
+#define _POSIX_C_SOURCE 200809L
 #include "input.h"
 #include "group.h"
 #include <stdlib.h>
@@ -11,41 +12,300 @@
 #include <stdbool.h>
 #include <string.h>
 #include <ctype.h>
-/** Temporary buffer size */
-#define BUFFER_SIZE 100
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <errno.h>
+#include <limits.h>
+/** Base for the integers in the input */
+#define BASE_TEN 10
+/** Size of the buffer a line reader starts with */
+#define READER_BUFFER_SIZE 262144
+/** Size of the buffer a file that can't be mapped is first read into */
+#define FILE_BUFFER_SIZE 65536
 /**
-    Reads a line from the given file
-    @param fp the pointer for the file
-    @return a pointer to a dynamically allocated memory containing the line
+    Reads the whole of a file that can't be mapped, such as a pipe, into a buffer that grows as it fills.
+    @param fd the file descriptor to read from
+    @param *file filled in with the buffer and the size of the file's contents
+    @return true if the file was read to its end, false if reading it failed
  */
-char *readLine( FILE *fp ) 
+static bool readWhole( int fd, MappedFile *file )
 {
-    //What buffer size should I set?
-    size_t bufferSize = BUFFER_SIZE;
-    size_t position = 0;
-    char *buffer = malloc(bufferSize);
+    size_t cap = FILE_BUFFER_SIZE;
+    size_t size = 0;
+    char *buffer = malloc(cap);
     if (buffer == NULL) {
-        return NULL;
+        fprintf(stderr, "Memory allocation issue.\n");
+        exit(EXIT_FAILURE);
     }
-
-    int ch;
-    while ((ch = fgetc(fp)) != EOF && ch != '\n') {
-        if (position >= bufferSize - 1) {
-            bufferSize *= DOUBLE_SIZE;
-            char *buffer2 = realloc(buffer, bufferSize);
-            if (buffer2 == NULL) {
-                free(buffer);
-                return NULL;
+    while (true) {
+        if (size == cap) {
+            cap *= DOUBLE_SIZE;
+            char *newBuffer = realloc(buffer, cap);
+            if (newBuffer == NULL) {
+                fprintf(stderr, "Memory allocation issue.\n");
+                exit(EXIT_FAILURE);
+            }
+            buffer = newBuffer;
+        }
+        ssize_t len = read(fd, buffer + size, cap - size);
+        if (len == 0) {
+            break;
+        }
+        if (len < 0) {
+            if (errno == EINTR) {
+                continue;
             }
-            buffer = buffer2;
+            free(buffer);
+            return false;
+        }
+        size += len;
+    }
+    file -> size = size;
+    file -> data = buffer;
+    file -> read = true;
+    return true;
+}
+
+/**
+    Maps a whole file into memory with the given protection, as a private mapping. A pipe or anything else
+    that isn't a regular file can't be mapped, so it is read into a buffer instead, which may be written to.
+    @param *filename the name of the file to map
+    @param *file filled in with the address and size of the file's contents
+    @param prot the protection of the mapping
+    @return true if the file was mapped, false if it couldn't be opened or read
+ */
+static bool mapWith( char const *filename, MappedFile *file, int prot )
+{
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return false;
+    }
+    if (!S_ISREG(st.st_mode)) {
+        bool whole = readWhole(fd, file);
+        close(fd);
+        return whole;
+    }
+    file -> size = st.st_size;
+    file -> data = NULL;
+    file -> read = false;
+    // an empty file has nothing to map
+    if (file -> size > 0) {
+        void *p = mmap(NULL, file -> size, prot, MAP_PRIVATE, fd, 0);
+        if (p == MAP_FAILED) {
+            close(fd);
+            return false;
         }
-        buffer[position++] = (char) ch;
+        // the file is read front to back once
+        posix_madvise(p, file -> size, POSIX_MADV_SEQUENTIAL);
+        file -> data = p;
+    }
+    close(fd);
+    return true;
+}
+
+/**
+    Maps a whole file into memory, read only, so it can be parsed in place.
+    @param *filename the name of the file to map
+    @param *file filled in with the address and size of the file's contents
+    @return true if the file was mapped, false if it couldn't be opened or read
+ */
+bool mapFile( char const *filename, MappedFile *file )
+{
+    return mapWith(filename, file, PROT_READ);
+}
+
+/**
+    Maps a whole file into memory as a private copy that can be written to. Pages are only copied once
+    they are written, and nothing written reaches the file.
+    @param *filename the name of the file to map
+    @param *file filled in with the address and size of the file's contents
+    @return true if the file was mapped, false if it couldn't be opened or read
+ */
+bool mapFileCopy( char const *filename, MappedFile *file )
+{
+    return mapWith(filename, file, PROT_READ | PROT_WRITE);
+}
+
+/**
+    Unmaps a file mapped with mapFile or mapFileCopy, or frees the buffer it was read into.
+    @param *file the file to unmap
+ */
+void unmapFile( MappedFile *file )
+{
+    if (file -> read) {
+        free((void *)file -> data);
+    }
+    else if (file -> data != NULL) {
+        munmap((void *)file -> data, file -> size);
+    }
+    file -> data = NULL;
+    file -> size = 0;
+}
+
+/**
+    Initializes a line reader for a file descriptor.
+    @param *reader the reader to initialize
+    @param fd the file descriptor to read from
+ */
+void initLineReader( LineReader *reader, int fd )
+{
+    reader -> fd = fd;
+    reader -> cap = READER_BUFFER_SIZE;
+    // one extra byte so the last line can always be terminated
+    reader -> buffer = malloc(reader -> cap + 1);
+    if (reader -> buffer == NULL) {
+        fprintf(stderr, "Memory allocation issue.\n");
+        exit(EXIT_FAILURE);
     }
+    reader -> start = 0;
+    reader -> end = 0;
+    reader -> eof = false;
+}
+
+/**
+    Frees the buffer of a line reader. The file descriptor is left open.
+    @param *reader the reader to free
+ */
+void freeLineReader( LineReader *reader )
+{
+    free(reader -> buffer);
+    reader -> buffer = NULL;
+}
 
-    if (position == 0 && ch == EOF) {
-        free(buffer);
+/**
+    Returns the next whole line already read into a reader's buffer, without reading any more. At the end
+    of the input the last line is returned even if it has no newline.
+    @param *reader the reader to take the line from
+    @return the line, which stays valid until the reader next reads, or NULL if there's no whole line yet
+ */
+char *bufferedLine( LineReader *reader )
+{
+    char *line = reader -> buffer + reader -> start;
+    char *nl = memchr(line, '\n', reader -> end - reader -> start);
+    if (nl != NULL) {
+        *nl = '\0';
+        reader -> start = nl - reader -> buffer + 1;
+        return line;
+    }
+    if (reader -> eof && reader -> start < reader -> end) {
+        reader -> buffer[reader -> end] = '\0';
+        reader -> start = reader -> end;
+        return line;
+    }
+    return NULL;
+}
+
+/**
+    Reads once from a reader's file descriptor into its buffer. The partial line at the end of the buffer
+    is moved to the front first, and the buffer grows if the line fills all of it. Reaching the end of the
+    input, or an error other than an interruption, marks the reader as at its end.
+    @param *reader the reader to fill
+    @return the number of bytes read, or -1 if nothing could be read right now, with errno telling why
+ */
+ssize_t fillLineReader( LineReader *reader )
+{
+    size_t partial = reader -> end - reader -> start;
+    memmove(reader -> buffer, reader -> buffer + reader -> start, partial);
+    reader -> start = 0;
+    reader -> end = partial;
+    if (partial == reader -> cap) {
+        reader -> cap *= DOUBLE_SIZE;
+        char *newBuffer = realloc(reader -> buffer, reader -> cap + 1);
+        if (newBuffer == NULL) {
+            fprintf(stderr, "Memory allocation issue.\n");
+            exit(EXIT_FAILURE);
+        }
+        reader -> buffer = newBuffer;
+    }
+
+    ssize_t len = read(reader -> fd, reader -> buffer + reader -> end, reader -> cap - reader -> end);
+    if (len > 0) {
+        reader -> end += len;
+    }
+    else if (len == 0 || (errno != EINTR && errno != EAGAIN && errno != EWOULDBLOCK)) {
+        reader -> eof = true;
+    }
+    return len;
+}
+
+/**
+    Reads the next line without allocating: the line is returned in place in the reader's buffer with its
+    newline replaced by a null terminator. The last line is returned even if it has no newline.
+    @param *reader the reader to read from
+    @return the line, which stays valid until the next call, or NULL at the end of the input
+ */
+char *nextLine( LineReader *reader )
+{
+    char *line;
+    while ((line = bufferedLine(reader)) == NULL && !reader -> eof) {
+        fillLineReader(reader);
+    }
+    return line;
+}
+
+/**
+    Checks for the characters that sscanf counts as white space.
+    @param ch the character to check
+    @return true if ch is white space
+ */
+bool isBlank( char ch )
+{
+    return ch == ' ' || ch == '\t' || ch == '\r' || ch == '\v' || ch == '\f' || ch == '\n';
+}
+
+/**
+    Skips white space in a line.
+    @param *p the start of the text to skip
+    @param *end the end of the line
+    @return the first character that isn't white space, or end
+ */
+char const *skipBlanks( char const *p, char const *end )
+{
+    while (p < end && isBlank(*p)) {
+        p++;
+    }
+    return p;
+}
+
+/**
+    Parses a decimal integer with an optional sign, the way %d does, after skipping white space.
+    @param *p the start of the text to parse
+    @param *end the end of the line
+    @param *value set to the integer that was parsed
+    @return the character after the integer, or NULL if there is no integer or it doesn't fit in an int
+ */
+char const *scanInt( char const *p, char const *end, int *value )
+{
+    p = skipBlanks(p, end);
+    bool negative = false;
+    if (p < end && (*p == '-' || *p == '+')) {
+        negative = *p == '-';
+        p++;
+    }
+    if (p == end || *p < '0' || *p > '9') {
+        return NULL;
+    }
+    long long v = 0;
+    while (p < end && *p >= '0' && *p <= '9') {
+        v = v * BASE_TEN + (*p - '0');
+        if (v > INT_MAX + 1LL) {
+            return NULL;
+        }
+        p++;
+    }
+    if (negative) {
+        v = -v;
+    }
+    if (v > INT_MAX) {
         return NULL;
     }
-    buffer[position] = '\0';
-    return buffer;
+    *value = (int) v;
+    return p;
 }
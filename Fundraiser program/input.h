@@ -8,9 +8,95 @@
 #include <stdbool.h>
 #include <string.h>
 #include <ctype.h>
+#include <sys/types.h>
+/** Struct for a file mapped into memory, or read into a buffer if it isn't a regular file */
+struct MappedFileStruct {
+    char const *data;
+    size_t size;
+    bool read;
+};
+typedef struct MappedFileStruct MappedFile;
 /**
-    Reads a line from the given file
-    @param fp the pointer for the file
-    @return a pointer to a dynamically allocated memory containing the line
+    Maps a whole file into memory, read only, so it can be parsed in place.
+    @param *filename the name of the file to map
+    @param *file filled in with the address and size of the file's contents
+    @return true if the file was mapped, false if it couldn't be opened or read
  */
-char *readLine( FILE *fp );
+bool mapFile( char const *filename, MappedFile *file );
+/**
+    Maps a whole file into memory as a private copy that can be written to. Pages are only copied once
+    they are written, and nothing written reaches the file.
+    @param *filename the name of the file to map
+    @param *file filled in with the address and size of the file's contents
+    @return true if the file was mapped, false if it couldn't be opened or read
+ */
+bool mapFileCopy( char const *filename, MappedFile *file );
+/**
+    Unmaps a file mapped with mapFile or mapFileCopy, or frees the buffer it was read into.
+    @param *file the file to unmap
+ */
+void unmapFile( MappedFile *file );
+/** Struct for reading lines from a file descriptor through one large, reused buffer */
+struct LineReaderStruct {
+    int fd;
+    char *buffer;
+    size_t cap;
+    size_t start;
+    size_t end;
+    bool eof;
+};
+typedef struct LineReaderStruct LineReader;
+/**
+    Initializes a line reader for a file descriptor.
+    @param *reader the reader to initialize
+    @param fd the file descriptor to read from
+ */
+void initLineReader( LineReader *reader, int fd );
+/**
+    Frees the buffer of a line reader. The file descriptor is left open.
+    @param *reader the reader to free
+ */
+void freeLineReader( LineReader *reader );
+/**
+    Returns the next whole line already read into a reader's buffer, without reading any more. At the end
+    of the input the last line is returned even if it has no newline.
+    @param *reader the reader to take the line from
+    @return the line, which stays valid until the reader next reads, or NULL if there's no whole line yet
+ */
+char *bufferedLine( LineReader *reader );
+/**
+    Reads once from a reader's file descriptor into its buffer. The partial line at the end of the buffer
+    is moved to the front first, and the buffer grows if the line fills all of it. Reaching the end of the
+    input, or an error other than an interruption, marks the reader as at its end.
+    @param *reader the reader to fill
+    @return the number of bytes read, or -1 if nothing could be read right now, with errno telling why
+ */
+ssize_t fillLineReader( LineReader *reader );
+/**
+    Reads the next line without allocating: the line is returned in place in the reader's buffer with its
+    newline replaced by a null terminator. The last line is returned even if it has no newline.
+    @param *reader the reader to read from
+    @return the line, which stays valid until the next call, or NULL at the end of the input
+ */
+char *nextLine( LineReader *reader );
+/**
+    Checks for the characters that sscanf counts as white space.
+    @param ch the character to check
+    @return true if ch is white space
+ */
+bool isBlank( char ch );
+/**
+    Skips white space in a line.
+    @param *p the start of the text to skip
+    @param *end the end of the line
+    @return the first character that isn't white space, or end
+ */
+char const *skipBlanks( char const *p, char const *end );
+/**
+    Parses a decimal integer with an optional sign, the way %d does, after skipping white space.
+    @param *p the start of the text to parse
+    @param *end the end of the line
+    @param *value set to the integer that was parsed
+    @return the character after the integer, or NULL if there is no integer or it doesn't fit in an int
+ */
+char const *scanInt( char const *p, char const *end, int *value );
@@ -0,0 +1,356 @@
+/**
+    @file journal.c
+    @author Sachi Vyas (smvyas)
+    A program that: Keeps an append-only journal of the sales recorded in a group, so they survive a crash.
+    Sales are committed to disk in batches by a thread of the journal's own, so a batch costs one sync and
+    recording a sale never waits for the disk. Whoever acknowledges a sale waits for it with syncJournal.
+ */
+#define _POSIX_C_SOURCE 200809L
+#include "input.h"
+#include "group.h"
+#include "journal.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+#include <stddef.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+/** Marks the start of a journal file */
+#define JOURNAL_MAGIC "FRJRNL1\n"
+/** Length of JOURNAL_MAGIC */
+#define MAGIC_LEN 8
+/** Size of the header at the start of a journal: the magic and the journal's id */
+#define JOURNAL_HEADER_SIZE (MAGIC_LEN + sizeof(unsigned long long))
+/** Offset basis of the FNV-1a hash that checks each record */
+#define FNV_OFFSET 2166136261u
+/** Prime of the FNV-1a hash that checks each record */
+#define FNV_PRIME 16777619u
+/** Number of nanoseconds in a millisecond */
+#define NANOS_PER_MILLI 1000000L
+/** Number of nanoseconds in a second */
+#define NANOS_PER_SECOND 1000000000L
+/** Shift that mixes the clock into a journal id */
+#define ID_SHIFT 32
+
+/**
+    Computes the check of a record, a hash of everything in it before the check itself.
+    @param *record the record
+    @return the check
+ */
+static unsigned int recordCheck( JournalRecord const *record )
+{
+    unsigned char const *p = (unsigned char const *) record;
+    unsigned int h = FNV_OFFSET;
+    for (size_t i = 0; i < offsetof(JournalRecord, check); i++) {
+        h = (h ^ p[i]) * FNV_PRIME;
+    }
+    return h;
+}
+
+/**
+    Writes all of a buffer to a file, retrying short writes.
+    @param fd the file
+    @param *data the bytes to write
+    @param size the number of bytes
+    @return false if the file couldn't be written
+ */
+static bool writeFully( int fd, void const *data, size_t size )
+{
+    char const *p = data;
+    while (size > 0) {
+        ssize_t n = write(fd, p, size);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        p += n;
+        size -= n;
+    }
+    return true;
+}
+
+/**
+    Commits batches of sales to disk until the journal is closed. A batch is committed when it fills up, when
+    its oldest sale has waited the journal's interval, when syncJournal wants it, or when the journal is
+    closed. The batch is swapped out under the lock and written without it, so sales can keep being added
+    while the disk is busy.
+    @param *arg the journal
+    @return NULL
+ */
+static void *runCommitter( void *arg )
+{
+    Journal *j = arg;
+    pthread_mutex_lock(&j -> lock);
+    while (!j -> stopping || j -> pendingCount > 0) {
+        if (!j -> stopping && j -> pendingCount < j -> batch && j -> wanted <= j -> committed) {
+            // wait for the first sale of a batch, then give the rest of it the interval to arrive
+            while (!j -> stopping && j -> pendingCount == 0) {
+                pthread_cond_wait(&j -> wake, &j -> lock);
+            }
+            struct timespec deadline;
+            clock_gettime(CLOCK_REALTIME, &deadline);
+            deadline.tv_nsec += (long) j -> intervalMs * NANOS_PER_MILLI;
+            deadline.tv_sec += deadline.tv_nsec / NANOS_PER_SECOND;
+            deadline.tv_nsec %= NANOS_PER_SECOND;
+            int status = 0;
+            while (!j -> stopping && j -> pendingCount < j -> batch && j -> wanted <= j -> committed &&
+                   status != ETIMEDOUT) {
+                status = pthread_cond_timedwait(&j -> wake, &j -> lock, &deadline);
+            }
+            if (j -> pendingCount == 0) {
+                continue;
+            }
+        }
+        JournalRecord *records = j -> pending;
+        int count = j -> pendingCount;
+        j -> pending = j -> writing;
+        j -> writing = records;
+        int cap = j -> pendingCap;
+        j -> pendingCap = j -> writingCap;
+        j -> writingCap = cap;
+        j -> pendingCount = 0;
+        pthread_mutex_unlock(&j -> lock);
+
+        bool ok = writeFully(j -> fd, records, count * sizeof(JournalRecord)) && fdatasync(j -> fd) == 0;
+
+        pthread_mutex_lock(&j -> lock);
+        if (!ok && !j -> failed) {
+            fprintf(stderr, "Can't write file: %s\n", j -> filename);
+            j -> failed = true;
+        }
+        j -> committed += count;
+        pthread_cond_broadcast(&j -> synced);
+    }
+    pthread_mutex_unlock(&j -> lock);
+    return NULL;
+}
+
+/**
+    Makes an id for a new journal, so a snapshot can tell whether a journal is the one it was saved with.
+    @return the id
+ */
+static unsigned long long newJournalId( void )
+{
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    unsigned long long id = (unsigned long long) now.tv_sec << ID_SHIFT ^ (unsigned long long) now.tv_nsec ^
+                            (unsigned long long) getpid() << (ID_SHIFT / 2);
+    return id == 0 ? 1 : id;
+}
+
+/**
+    Replays the records of a journal into a group through sellItem, the way the sale command records them,
+    and finds where the last whole, intact record ends.
+    @param *file the mapped journal
+    @param *group the group to replay into
+    @param skip the number of records at the start the group already holds
+    @return the number of intact records
+ */
+static long long replayJournal( MappedFile const *file, Group *group, long long skip )
+{
+    long long count = (file -> size - JOURNAL_HEADER_SIZE) / sizeof(JournalRecord);
+    char const *p = file -> data + JOURNAL_HEADER_SIZE;
+    for (long long i = 0; i < count; i++) {
+        JournalRecord record;
+        memcpy(&record, p + i * sizeof(JournalRecord), sizeof(record));
+        if (record.check != recordCheck(&record)) {
+            return i;
+        }
+        if (i >= skip) {
+            char memberId[JOURNAL_ID_LEN + 1];
+            memcpy(memberId, record.memberId, JOURNAL_ID_LEN);
+            memberId[JOURNAL_ID_LEN] = '\0';
+            sellItem(group, memberId, record.itemId, record.quantity);
+        }
+    }
+    return count;
+}
+
+/**
+    Opens a journal for a group, creating the file if there isn't one, and replays the sales already in it
+    into the group the way the sale command records them. A group loaded from a snapshot skips the sales of
+    the same journal that the snapshot already holds. A record cut short by a crash ends the journal and is
+    cut off. From then on every sale recorded in the group is added to the journal.
+    @param *filename the name of the journal file
+    @param *group the group the journal belongs to
+    @param batch the number of sales to commit to disk together
+    @param intervalMs the longest time in milliseconds a sale waits to be committed
+    @return the journal, or NULL if the file couldn't be opened or isn't a journal
+ */
+Journal *openJournal( char const *filename, Group *group, int batch, int intervalMs )
+{
+    int fd = open(filename, O_RDWR | O_CREAT, 0644);
+    if (fd < 0) {
+        return NULL;
+    }
+    MappedFile file;
+    if (!mapFile(filename, &file)) {
+        close(fd);
+        return NULL;
+    }
+    unsigned long long id = 0;
+    long long records = 0;
+    if (file.size == 0) {
+        // a new journal starts with its header, synced so the id a snapshot refers to is never lost
+        char header[JOURNAL_HEADER_SIZE];
+        id = newJournalId();
+        memcpy(header, JOURNAL_MAGIC, MAGIC_LEN);
+        memcpy(header + MAGIC_LEN, &id, sizeof(id));
+        if (!writeFully(fd, header, sizeof(header)) || fdatasync(fd) != 0) {
+            close(fd);
+            return NULL;
+        }
+    }
+    else {
+        if (file.size < JOURNAL_HEADER_SIZE || memcmp(file.data, JOURNAL_MAGIC, MAGIC_LEN) != 0) {
+            unmapFile(&file);
+            close(fd);
+            return NULL;
+        }
+        memcpy(&id, file.data + MAGIC_LEN, sizeof(id));
+        // a snapshot saved with this journal already holds its first sales, which must all still be in it
+        long long skip = group -> journalId == id ? group -> journalRecords : 0;
+        records = replayJournal(&file, group, skip);
+        if (records < skip) {
+            unmapFile(&file);
+            close(fd);
+            return NULL;
+        }
+        off_t end = JOURNAL_HEADER_SIZE + records * sizeof(JournalRecord);
+        if ((size_t) end != file.size && ftruncate(fd, end) != 0) {
+            unmapFile(&file);
+            close(fd);
+            return NULL;
+        }
+    }
+    unmapFile(&file);
+    lseek(fd, 0, SEEK_END);
+
+    Journal *j = (Journal *)malloc(sizeof(Journal));
+    if (j == NULL) {
+        fprintf(stderr, "Memory allocation issue.\n");
+        exit(EXIT_FAILURE);
+    }
+    j -> fd = fd;
+    j -> filename = (char *)malloc(strlen(filename) + 1);
+    j -> id = id;
+    j -> batch = batch < 1 ? 1 : batch;
+    j -> intervalMs = intervalMs < 0 ? 0 : intervalMs;
+    j -> pendingCap = j -> batch;
+    j -> writingCap = j -> batch;
+    j -> pending = (JournalRecord *)malloc(j -> pendingCap * sizeof(JournalRecord));
+    j -> writing = (JournalRecord *)malloc(j -> writingCap * sizeof(JournalRecord));
+    if (j -> filename == NULL || j -> pending == NULL || j -> writing == NULL) {
+        fprintf(stderr, "Memory allocation issue.\n");
+        exit(EXIT_FAILURE);
+    }
+    strcpy(j -> filename, filename);
+    j -> pendingCount = 0;
+    j -> appended = 0;
+    j -> committed = 0;
+    j -> wanted = 0;
+    j -> stopping = false;
+    j -> failed = false;
+    pthread_mutex_init(&j -> lock, NULL);
+    pthread_cond_init(&j -> wake, NULL);
+    pthread_cond_init(&j -> synced, NULL);
+    if (pthread_create(&j -> committer, NULL, runCommitter, j) != 0) {
+        fprintf(stderr, "Can't start a worker thread.\n");
+        exit(EXIT_FAILURE);
+    }
+    group -> journal = j;
+    group -> journalId = id;
+    group -> journalRecords = records;
+    return j;
+}
+
+/**
+    Adds a sale to the journal's pending batch. The batch is committed once it is full, or once the oldest
+    sale in it has waited the journal's interval.
+    @param *journal the journal
+    @param *memberId the id of the member who made the sale
+    @param itemId the id of the item sold
+    @param quantity how many of the item were sold
+ */
+void appendSale( Journal *journal, char const *memberId, int itemId, int quantity )
+{
+    JournalRecord record;
+    memset(&record, 0, sizeof(record));
+    strncpy(record.memberId, memberId, JOURNAL_ID_LEN);
+    record.itemId = itemId;
+    record.quantity = quantity;
+    record.check = recordCheck(&record);
+
+    pthread_mutex_lock(&journal -> lock);
+    // the committer may be writing a full batch, so the pending one keeps growing meanwhile
+    if (journal -> pendingCount == journal -> pendingCap) {
+        journal -> pendingCap *= DOUBLE_SIZE;
+        JournalRecord *grown = realloc(journal -> pending, journal -> pendingCap * sizeof(JournalRecord));
+        if (grown == NULL) {
+            fprintf(stderr, "Memory allocation issue.\n");
+            exit(EXIT_FAILURE);
+        }
+        journal -> pending = grown;
+    }
+    journal -> pending[journal -> pendingCount++] = record;
+    journal -> appended++;
+    if (journal -> pendingCount == 1 || journal -> pendingCount == journal -> batch) {
+        pthread_cond_signal(&journal -> wake);
+    }
+    pthread_mutex_unlock(&journal -> lock);
+}
+
+/**
+    Commits the pending batch at once, without waiting for it to fill, and waits until every sale added so
+    far is on disk.
+    @param *journal the journal
+    @return false if any sale couldn't be written to disk
+ */
+bool syncJournal( Journal *journal )
+{
+    pthread_mutex_lock(&journal -> lock);
+    long long target = journal -> appended;
+    if (journal -> committed < target) {
+        if (journal -> wanted < target) {
+            journal -> wanted = target;
+        }
+        pthread_cond_signal(&journal -> wake);
+        while (journal -> committed < target) {
+            pthread_cond_wait(&journal -> synced, &journal -> lock);
+        }
+    }
+    bool ok = !journal -> failed;
+    pthread_mutex_unlock(&journal -> lock);
+    return ok;
+}
+
+/**
+    Commits the sales still pending, stops the journal's thread and closes the journal.
+    @param *journal the journal to close
+    @return false if any sale couldn't be written to disk
+ */
+bool closeJournal( Journal *journal )
+{
+    pthread_mutex_lock(&journal -> lock);
+    journal -> stopping = true;
+    pthread_cond_signal(&journal -> wake);
+    pthread_mutex_unlock(&journal -> lock);
+    pthread_join(journal -> committer, NULL);
+
+    bool ok = !journal -> failed && close(journal -> fd) == 0;
+    pthread_mutex_destroy(&journal -> lock);
+    pthread_cond_destroy(&journal -> wake);
+    pthread_cond_destroy(&journal -> synced);
+    free(journal -> filename);
+    free(journal -> pending);
+    free(journal -> writing);
+    free(journal);
+    return ok;
+}
@@ -0,0 +1,96 @@
+/**
+    @file journal.h
+    @author Sachi Vyas (smvyas)
+    A program that: The prototype for journal.c
+ */
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <pthread.h>
+
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+/** Number of sales the journal commits to disk together unless told otherwise */
+#define JOURNAL_BATCH 1024
+/** Longest time in milliseconds a sale waits to be committed unless told otherwise */
+#define JOURNAL_INTERVAL_MS 10
+/** Room for a member id in a journal record, the longest id with no terminator */
+#define JOURNAL_ID_LEN 8
+
+struct GroupStruct;
+
+/** Struct for one sale as it is stored in the journal */
+struct JournalRecordStruct {
+    char memberId[JOURNAL_ID_LEN];
+    int itemId;
+    int quantity;
+    unsigned int check;
+};
+typedef struct JournalRecordStruct JournalRecord;
+
+/**
+    Struct for an append-only journal of the sales recorded in a group. Sales are added to a pending batch,
+    and a thread of the journal's own writes each batch out and syncs it to disk. The counts of sales added
+    and committed let a caller wait for every sale added so far to be on disk.
+ */
+struct JournalStruct {
+    int fd;
+    char *filename;
+    unsigned long long id;
+    JournalRecord *pending;
+    int pendingCount;
+    int pendingCap;
+    JournalRecord *writing;
+    int writingCap;
+    int batch;
+    int intervalMs;
+    long long appended;
+    long long committed;
+    long long wanted;
+    bool stopping;
+    bool failed;
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    pthread_cond_t synced;
+    pthread_t committer;
+};
+typedef struct JournalStruct Journal;
+
+/**
+    Opens a journal for a group, creating the file if there isn't one, and replays the sales already in it
+    into the group the way the sale command records them. A group loaded from a snapshot skips the sales of
+    the same journal that the snapshot already holds, and a journal holding fewer sales than that snapshot
+    isn't the one it was saved with. A record cut short by a crash ends the journal and is cut off. From then
+    on every sale recorded in the group is added to the journal.
+    @param *filename the name of the journal file
+    @param *group the group the journal belongs to
+    @param batch the number of sales to commit to disk together
+    @param intervalMs the longest time in milliseconds a sale waits to be committed
+    @return the journal, or NULL if the file couldn't be opened or isn't a journal
+ */
+Journal *openJournal( char const *filename, struct GroupStruct *group, int batch, int intervalMs );
+/**
+    Adds a sale to the journal's pending batch. The batch is committed once it is full, or once the oldest
+    sale in it has waited the journal's interval.
+    @param *journal the journal
+    @param *memberId the id of the member who made the sale
+    @param itemId the id of the item sold
+    @param quantity how many of the item were sold
+ */
+void appendSale( Journal *journal, char const *memberId, int itemId, int quantity );
+/**
+    Commits the pending batch at once, without waiting for it to fill, and waits until every sale added so
+    far is on disk.
+    @param *journal the journal
+    @return false if any sale couldn't be written to disk
+ */
+bool syncJournal( Journal *journal );
+/**
+    Commits the sales still pending, stops the journal's thread and closes the journal.
+    @param *journal the journal to close
+    @return false if any sale couldn't be written to disk
+ */
+bool closeJournal( Journal *journal );
+
+#endif
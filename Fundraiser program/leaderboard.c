@@ -0,0 +1,323 @@
+/**
+    @file leaderboard.c
+    @author Sachi Vyas (smvyas)
+    A program that: Keeps the members ranked by how much revenue they brought in, in an AVL tree that
+    is updated as sales are made, so the top sellers can be listed without sorting.
+ */
+#include "group.h"
+#include "leaderboard.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+
+/** Slot value used for a missing child */
+#define NO_NODE -1
+/** Deepest an AVL tree with up to 2^31 nodes can get */
+#define MAX_DEPTH 64
+
+/**
+    Initializes an empty leaderboard.
+    @param *board the leaderboard to initialize
+ */
+void initLeaderboard( Leaderboard *board )
+{
+    board -> nodes = (LeaderNode *)malloc(INITIAL_SIZE * sizeof(LeaderNode));
+    if (board -> nodes == NULL) {
+        fprintf(stderr, "Memory allocation issue.\n");
+        exit(EXIT_FAILURE);
+    }
+    board -> count = 0;
+    board -> cap = INITIAL_SIZE;
+    board -> root = NO_NODE;
+    board -> changing = NULL;
+    board -> changingArg = NULL;
+}
+
+/**
+    Frees the storage used by the nodes of a leaderboard.
+    @param *board the leaderboard to free
+ */
+void freeLeaderboard( Leaderboard *board )
+{
+    free(board -> nodes);
+    board -> nodes = NULL;
+    board -> count = 0;
+    board -> cap = 0;
+    board -> root = NO_NODE;
+}
+
+/**
+    Checks whether one node ranks ahead of another: more revenue first, then the smaller member id.
+    @param *nodes the nodes of the tree
+    @param a the slot of the first node
+    @param b the slot of the second node
+    @return true if node a comes before node b in the ranking
+ */
+static bool ranksBefore( LeaderNode const *nodes, int a, int b )
+{
+    if (nodes[a].revenue != nodes[b].revenue) {
+        return nodes[a].revenue > nodes[b].revenue;
+    }
+    return nodes[a].member -> idKey < nodes[b].member -> idKey;
+}
+
+/**
+    Returns the height of a subtree.
+    @param *nodes the nodes of the tree
+    @param slot the root of the subtree, or NO_NODE
+    @return the height of the subtree, 0 if it is empty
+ */
+static int heightOf( LeaderNode const *nodes, int slot )
+{
+    return slot == NO_NODE ? 0 : nodes[slot].height;
+}
+
+/**
+    Tells the leaderboard's hook that a node is about to be written. Every node a change writes has its
+    height recomputed or is inserted as a leaf, so those are the only places that need to.
+    @param *board the leaderboard
+    @param slot the node
+ */
+static void changing( Leaderboard *board, int slot )
+{
+    if (board -> changing != NULL) {
+        board -> changing(board -> changingArg, slot);
+    }
+}
+
+/**
+    Recomputes the height of a node from its children.
+    @param *board the leaderboard
+    @param slot the node to update
+ */
+static void updateHeight( Leaderboard *board, int slot )
+{
+    LeaderNode *nodes = board -> nodes;
+    changing(board, slot);
+    int l = heightOf(nodes, nodes[slot].left);
+    int r = heightOf(nodes, nodes[slot].right);
+    nodes[slot].height = (l > r ? l : r) + 1;
+}
+
+/**
+    Rotates a subtree to the left.
+    @param *board the leaderboard
+    @param slot the root of the subtree
+    @return the new root of the subtree
+ */
+static int rotateLeft( Leaderboard *board, int slot )
+{
+    LeaderNode *nodes = board -> nodes;
+    int top = nodes[slot].right;
+    nodes[slot].right = nodes[top].left;
+    nodes[top].left = slot;
+    updateHeight(board, slot);
+    updateHeight(board, top);
+    return top;
+}
+
+/**
+    Rotates a subtree to the right.
+    @param *board the leaderboard
+    @param slot the root of the subtree
+    @return the new root of the subtree
+ */
+static int rotateRight( Leaderboard *board, int slot )
+{
+    LeaderNode *nodes = board -> nodes;
+    int top = nodes[slot].left;
+    nodes[slot].left = nodes[top].right;
+    nodes[top].right = slot;
+    updateHeight(board, slot);
+    updateHeight(board, top);
+    return top;
+}
+
+/**
+    Restores the AVL balance of a subtree after one of its children changed height.
+    @param *board the leaderboard
+    @param slot the root of the subtree
+    @return the new root of the subtree
+ */
+static int rebalance( Leaderboard *board, int slot )
+{
+    LeaderNode *nodes = board -> nodes;
+    updateHeight(board, slot);
+    int balance = heightOf(nodes, nodes[slot].left) - heightOf(nodes, nodes[slot].right);
+    if (balance > 1) {
+        int child = nodes[slot].left;
+        if (heightOf(nodes, nodes[child].left) < heightOf(nodes, nodes[child].right)) {
+            nodes[slot].left = rotateLeft(board, child);
+        }
+        return rotateRight(board, slot);
+    }
+    if (balance < -1) {
+        int child = nodes[slot].right;
+        if (heightOf(nodes, nodes[child].right) < heightOf(nodes, nodes[child].left)) {
+            nodes[slot].right = rotateRight(board, child);
+        }
+        return rotateLeft(board, slot);
+    }
+    return slot;
+}
+
+/**
+    Inserts a detached node into a subtree.
+    @param *board the leaderboard
+    @param root the root of the subtree, or NO_NODE
+    @param slot the node to insert
+    @return the new root of the subtree
+ */
+static int insertNode( Leaderboard *board, int root, int slot )
+{
+    LeaderNode *nodes = board -> nodes;
+    if (root == NO_NODE) {
+        changing(board, slot);
+        nodes[slot].left = NO_NODE;
+        nodes[slot].right = NO_NODE;
+        nodes[slot].height = 1;
+        return slot;
+    }
+    if (ranksBefore(nodes, slot, root)) {
+        nodes[root].left = insertNode(board, nodes[root].left, slot);
+    }
+    else {
+        nodes[root].right = insertNode(board, nodes[root].right, slot);
+    }
+    return rebalance(board, root);
+}
+
+/**
+    Detaches the first node in rank order from a subtree.
+    @param *board the leaderboard
+    @param root the root of the subtree, which must not be empty
+    @param *first set to the slot of the detached node
+    @return the new root of the subtree
+ */
+static int removeFirst( Leaderboard *board, int root, int *first )
+{
+    LeaderNode *nodes = board -> nodes;
+    if (nodes[root].left == NO_NODE) {
+        *first = root;
+        return nodes[root].right;
+    }
+    nodes[root].left = removeFirst(board, nodes[root].left, first);
+    return rebalance(board, root);
+}
+
+/**
+    Detaches a node from a subtree. The node's revenue must not have changed since it was inserted.
+    @param *board the leaderboard
+    @param root the root of the subtree containing the node
+    @param slot the node to detach
+    @return the new root of the subtree
+ */
+static int removeNode( Leaderboard *board, int root, int slot )
+{
+    LeaderNode *nodes = board -> nodes;
+    if (root == slot) {
+        if (nodes[root].left == NO_NODE) {
+            return nodes[root].right;
+        }
+        if (nodes[root].right == NO_NODE) {
+            return nodes[root].left;
+        }
+        int successor;
+        int right = removeFirst(board, nodes[root].right, &successor);
+        nodes[successor].left = nodes[root].left;
+        nodes[successor].right = right;
+        return rebalance(board, successor);
+    }
+    if (ranksBefore(nodes, slot, root)) {
+        nodes[root].left = removeNode(board, nodes[root].left, slot);
+    }
+    else {
+        nodes[root].right = removeNode(board, nodes[root].right, slot);
+    }
+    return rebalance(board, root);
+}
+
+/**
+    Adds a member with no revenue to the leaderboard.
+    @param *board the leaderboard to add the member to
+    @param *member the member to add
+    @return the slot of the member's node, used to update it later
+ */
+int addSeller( Leaderboard *board, Member *member )
+{
+    if (board -> count >= board -> cap) {
+        board -> cap *= DOUBLE_SIZE;
+        LeaderNode *newNodes = realloc(board -> nodes, board -> cap * sizeof(LeaderNode));
+        if (newNodes == NULL) {
+            fprintf(stderr, "Memory allocation issue.\n");
+            exit(EXIT_FAILURE);
+        }
+        board -> nodes = newNodes;
+    }
+    int slot = board -> count++;
+    board -> nodes[slot].member = member;
+    board -> nodes[slot].revenue = 0;
+    board -> root = insertNode(board, board -> root, slot);
+    return slot;
+}
+
+/**
+    Adds to the revenue of a member and moves the member to its new place in the ranking.
+    @param *board the leaderboard the member is in
+    @param slot the slot returned by addSeller for the member
+    @param amount how much to add to the member's revenue
+ */
+void addRevenue( Leaderboard *board, int slot, int amount )
+{
+    if (amount == 0) {
+        return;
+    }
+    board -> root = removeNode(board, board -> root, slot);
+    board -> nodes[slot].revenue += amount;
+    board -> root = insertNode(board, board -> root, slot);
+}
+
+/**
+    Takes a member out of the leaderboard. The node in the last slot is moved into the member's slot, so the
+    nodes stay packed.
+    @param *board the leaderboard the member is in
+    @param slot the slot returned by addSeller for the member
+    @return the member whose node was moved into the slot and must be told its new slot, or NULL if none was
+ */
+Member *removeSeller( Leaderboard *board, int slot )
+{
+    board -> root = removeNode(board, board -> root, slot);
+    int last = --board -> count;
+    if (slot == last) {
+        return NULL;
+    }
+    board -> root = removeNode(board, board -> root, last);
+    board -> nodes[slot].member = board -> nodes[last].member;
+    board -> nodes[slot].revenue = board -> nodes[last].revenue;
+    board -> root = insertNode(board, board -> root, slot);
+    return board -> nodes[slot].member;
+}
+
+/**
+    Visits members from the highest revenue to the lowest, breaking ties by member id.
+    @param *board the leaderboard to walk
+    @param limit the most members to visit, or a negative number to visit all of them
+    @param *visit the function called for each member in rank order
+    @param *data passed along to each call of visit
+ */
+void forEachSeller( Leaderboard const *board, int limit, void (*visit)( Member *member, void *data ), void *data )
+{
+    int stack[MAX_DEPTH];
+    int depth = 0;
+    int slot = board -> root;
+    while ((slot != NO_NODE || depth > 0) && limit != 0) {
+        while (slot != NO_NODE) {
+            stack[depth++] = slot;
+            slot = board -> nodes[slot].left;
+        }
+        slot = stack[--depth];
+        visit(board -> nodes[slot].member, data);
+        limit--;
+        slot = board -> nodes[slot].right;
+    }
+}
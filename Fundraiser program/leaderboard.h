@@ -0,0 +1,82 @@
+/**
+    @file leaderboard.h
+    @author Sachi Vyas (smvyas)
+    A program that: The prototype for leaderboard.c
+ */
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+
+#ifndef LEADERBOARD_H
+#define LEADERBOARD_H
+
+struct MemberStruct;
+
+/** Struct for one member's place in the leaderboard tree */
+struct LeaderNodeStruct {
+    struct MemberStruct *member;
+    int revenue;
+    int left;
+    int right;
+    int height;
+};
+typedef struct LeaderNodeStruct LeaderNode;
+
+/**
+    Struct for the leaderboard, a balanced tree of members ordered by revenue. If it has one, the hook is
+    called with its argument and the slot of every node about to be written, so a copy of the nodes can
+    be brought up to date with just the ones that changed.
+ */
+struct LeaderboardStruct {
+    LeaderNode *nodes;
+    int count;
+    int cap;
+    int root;
+    void (*changing)( void *arg, int slot );
+    void *changingArg;
+};
+typedef struct LeaderboardStruct Leaderboard;
+
+/**
+    Initializes an empty leaderboard.
+    @param *board the leaderboard to initialize
+ */
+void initLeaderboard( Leaderboard *board );
+/**
+    Frees the storage used by the nodes of a leaderboard.
+    @param *board the leaderboard to free
+ */
+void freeLeaderboard( Leaderboard *board );
+/**
+    Adds a member with no revenue to the leaderboard.
+    @param *board the leaderboard to add the member to
+    @param *member the member to add
+    @return the slot of the member's node, used to update it later
+ */
+int addSeller( Leaderboard *board, struct MemberStruct *member );
+/**
+    Adds to the revenue of a member and moves the member to its new place in the ranking.
+    @param *board the leaderboard the member is in
+    @param slot the slot returned by addSeller for the member
+    @param amount how much to add to the member's revenue
+ */
+void addRevenue( Leaderboard *board, int slot, int amount );
+/**
+    Takes a member out of the leaderboard. The node in the last slot is moved into the member's slot, so the
+    nodes stay packed.
+    @param *board the leaderboard the member is in
+    @param slot the slot returned by addSeller for the member
+    @return the member whose node was moved into the slot and must be told its new slot, or NULL if none was
+ */
+struct MemberStruct *removeSeller( Leaderboard *board, int slot );
+/**
+    Visits members from the highest revenue to the lowest, breaking ties by member id.
+    @param *board the leaderboard to walk
+    @param limit the most members to visit, or a negative number to visit all of them
+    @param *visit the function called for each member in rank order
+    @param *data passed along to each call of visit
+ */
+void forEachSeller( Leaderboard const *board, int limit, void (*visit)( struct MemberStruct *member, void *data ),
+                    void *data );
+
+#endif
@@ -0,0 +1,316 @@
+/**
+    @file output.c
+    @author Sachi Vyas (smvyas)
+    A program that: Builds the program's output in one large buffer, with hand written functions for the
+    fixed width fields of a report, and writes the buffer out with a single write call when it fills up.
+ */
+#define _POSIX_C_SOURCE 200809L
+#include "output.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+#include <stdarg.h>
+#include <errno.h>
+#include <unistd.h>
+
+/** Size of an output buffer */
+#define OUTPUT_BUFFER_SIZE 262144
+/** Most characters a long long can take when printed, with its sign */
+#define INT_DIGITS 20
+/** Base of printed integers */
+#define BASE_TEN 10
+/** Factor the buffer of an output for OUTPUT_MEMORY grows by */
+#define GROW_FACTOR 2
+
+/**
+    Initializes an output buffer for a file descriptor. An output for OUTPUT_MEMORY never writes anything: its
+    buffer grows to hold everything added, until it is taken out with consumeOutput.
+    @param *out the output to initialize
+    @param fd the file descriptor to write to, or OUTPUT_MEMORY
+ */
+void initOutput( Output *out, int fd )
+{
+    out -> fd = fd;
+    out -> cap = OUTPUT_BUFFER_SIZE;
+    out -> len = 0;
+    out -> written = 0;
+    out -> beforeWrite = NULL;
+    out -> beforeWriteArg = NULL;
+    out -> buffer = malloc(out -> cap);
+    if (out -> buffer == NULL) {
+        fprintf(stderr, "Memory allocation issue.\n");
+        exit(EXIT_FAILURE);
+    }
+}
+
+/**
+    Writes a run of bytes to an output's file descriptor, continuing after short writes and interruptions. If
+    the file descriptor can't be written any more, the rest is dropped, as stdio would. The output's hook is
+    called first.
+    @param *out the output
+    @param *data the bytes to write
+    @param size the number of bytes
+ */
+static void writeAll( Output *out, char const *data, size_t size )
+{
+    if (out -> beforeWrite != NULL && size > 0) {
+        out -> beforeWrite(out -> beforeWriteArg);
+    }
+    out -> written += size;
+    while (size > 0) {
+        ssize_t n = write(out -> fd, data, size);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return;
+        }
+        data += n;
+        size -= n;
+    }
+}
+
+/**
+    Writes everything in the buffer to the file descriptor with as few write calls as it takes. An output for
+    OUTPUT_MEMORY keeps what it has.
+    @param *out the output to flush
+ */
+void flushOutput( Output *out )
+{
+    if (out -> fd != OUTPUT_MEMORY) {
+        writeAll(out, out -> buffer, out -> len);
+        out -> len = 0;
+    }
+}
+
+/**
+    Removes bytes from the front of an output's buffer once they have been written out some other way.
+    @param *out the output
+    @param count the number of bytes written, no more than are in the buffer
+ */
+void consumeOutput( Output *out, size_t count )
+{
+    memmove(out -> buffer, out -> buffer + count, out -> len - count);
+    out -> len -= count;
+    out -> written += count;
+}
+
+/**
+    Grows the buffer of an output for OUTPUT_MEMORY until there's room for some more bytes.
+    @param *out the output
+    @param size the number of bytes needed
+ */
+static void growOutput( Output *out, size_t size )
+{
+    size_t cap = out -> cap;
+    while (cap - out -> len < size) {
+        cap *= GROW_FACTOR;
+    }
+    char *buffer = realloc(out -> buffer, cap);
+    if (buffer == NULL) {
+        fprintf(stderr, "Memory allocation issue.\n");
+        exit(EXIT_FAILURE);
+    }
+    out -> buffer = buffer;
+    out -> cap = cap;
+}
+
+/**
+    Flushes an output and frees its buffer. The file descriptor is left open.
+    @param *out the output to free
+ */
+void freeOutput( Output *out )
+{
+    flushOutput(out);
+    free(out -> buffer);
+    out -> buffer = NULL;
+}
+
+/**
+    Returns the number of bytes added to an output so far, whether or not they have been written yet.
+    @param *out the output
+    @return the number of bytes
+ */
+long long outputBytes( Output const *out )
+{
+    return out -> written + out -> len;
+}
+
+/**
+    Makes sure there's room for some more bytes in the buffer, flushing it if there isn't, or growing it
+    for an output for OUTPUT_MEMORY.
+    @param *out the output
+    @param size the number of bytes needed, no more than the size of the buffer
+    @return where the bytes go
+ */
+static char *reserve( Output *out, size_t size )
+{
+    if (out -> cap - out -> len < size) {
+        if (out -> fd == OUTPUT_MEMORY) {
+            growOutput(out, size);
+        }
+        else {
+            flushOutput(out);
+        }
+    }
+    return out -> buffer + out -> len;
+}
+
+/**
+    Adds a run of bytes to the output. Runs longer than the buffer are written straight through.
+    @param *out the output to add to
+    @param *data the bytes
+    @param size the number of bytes
+ */
+void putBytes( Output *out, char const *data, size_t size )
+{
+    if (size > out -> cap && out -> fd != OUTPUT_MEMORY) {
+        flushOutput(out);
+        writeAll(out, data, size);
+        return;
+    }
+    memcpy(reserve(out, size), data, size);
+    out -> len += size;
+}
+
+/**
+    Adds a character to the output.
+    @param *out the output to add to
+    @param ch the character
+ */
+void putChar( Output *out, char ch )
+{
+    *reserve(out, 1) = ch;
+    out -> len++;
+}
+
+/**
+    Adds a string to the output, like %s.
+    @param *out the output to add to
+    @param *str the string
+ */
+void putText( Output *out, char const *str )
+{
+    putBytes(out, str, strlen(str));
+}
+
+/**
+    Adds a run of spaces to the output.
+    @param *out the output to add to
+    @param count the number of spaces, which may be zero or less
+ */
+static void putSpaces( Output *out, int count )
+{
+    if (count > 0) {
+        memset(reserve(out, count), ' ', count);
+        out -> len += count;
+    }
+}
+
+/**
+    Adds a string padded with spaces on the right to at least a width, like %-*s.
+    @param *out the output to add to
+    @param *str the string
+    @param width the smallest number of characters to add
+ */
+void putLeft( Output *out, char const *str, int width )
+{
+    size_t len = strlen(str);
+    putBytes(out, str, len);
+    putSpaces(out, width - (int) len);
+}
+
+/**
+    Converts an integer to decimal at the end of a small buffer.
+    @param value the integer
+    @param *end the end of the buffer, which needs room for INT_DIGITS characters before it
+    @return the start of the digits
+ */
+static char *formatInt( long long value, char *end )
+{
+    // work with the magnitude as unsigned, so the most negative value doesn't overflow
+    unsigned long long magnitude = value < 0 ? 0ull - (unsigned long long) value : (unsigned long long) value;
+    char *p = end;
+    do {
+        *--p = '0' + magnitude % BASE_TEN;
+        magnitude /= BASE_TEN;
+    } while (magnitude != 0);
+    if (value < 0) {
+        *--p = '-';
+    }
+    return p;
+}
+
+/**
+    Adds an integer padded with spaces on the left to at least a width, like %*lld.
+    @param *out the output to add to
+    @param value the integer
+    @param width the smallest number of characters to add
+ */
+void putInt( Output *out, long long value, int width )
+{
+    char digits[INT_DIGITS];
+    char *end = digits + INT_DIGITS;
+    char *start = formatInt(value, end);
+    putSpaces(out, width - (int)(end - start));
+    putBytes(out, start, end - start);
+}
+
+/**
+    Adds an integer padded with spaces on the right to at least a width, like %-*lld.
+    @param *out the output to add to
+    @param value the integer
+    @param width the smallest number of characters to add
+ */
+void putIntLeft( Output *out, long long value, int width )
+{
+    char digits[INT_DIGITS];
+    char *end = digits + INT_DIGITS;
+    char *start = formatInt(value, end);
+    putBytes(out, start, end - start);
+    putSpaces(out, width - (int)(end - start));
+}
+
+/**
+    Adds formatted text to the output, the way printf would. This is for the odd line, rows of a report are
+    faster to build with the other functions.
+    @param *out the output to add to
+    @param *format the printf format
+ */
+void putFormat( Output *out, char const *format, ... )
+{
+    va_list args;
+    va_start(args, format);
+    va_list again;
+    va_copy(again, args);
+    int size = vsnprintf(out -> buffer + out -> len, out -> cap - out -> len, format, args);
+    va_end(args);
+    if (size >= 0 && (size_t) size >= out -> cap - out -> len) {
+        // it didn't fit, so make room for it, or format it on its own if it's bigger than the buffer
+        if (out -> fd == OUTPUT_MEMORY) {
+            growOutput(out, (size_t) size + 1);
+            vsnprintf(out -> buffer + out -> len, out -> cap - out -> len, format, again);
+        }
+        else if ((size_t) size < out -> cap) {
+            flushOutput(out);
+            vsnprintf(out -> buffer, out -> cap, format, again);
+        }
+        else {
+            flushOutput(out);
+            char *text = malloc(size + 1);
+            if (text == NULL) {
+                fprintf(stderr, "Memory allocation issue.\n");
+                exit(EXIT_FAILURE);
+            }
+            vsnprintf(text, size + 1, format, again);
+            writeAll(out, text, size);
+            free(text);
+            size = 0;
+        }
+    }
+    va_end(again);
+    if (size > 0) {
+        out -> len += size;
+    }
+}
@@ -0,0 +1,109 @@
+/**
+    @file output.h
+    @author Sachi Vyas (smvyas)
+    A program that: The prototype for output.c
+ */
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+
+#ifndef OUTPUT_H
+#define OUTPUT_H
+
+/** File descriptor of an output that only collects into memory, for someone else to write out */
+#define OUTPUT_MEMORY -1
+
+/**
+    Struct for output collected in one large buffer and written to a file descriptor a buffer at a time. If
+    it has one, the hook is called with its argument before anything is written, so what the output says has
+    happened can be made to happen first.
+ */
+struct OutputStruct {
+    int fd;
+    char *buffer;
+    size_t len;
+    size_t cap;
+    long long written;
+    void (*beforeWrite)( void *arg );
+    void *beforeWriteArg;
+};
+typedef struct OutputStruct Output;
+
+/**
+    Initializes an output buffer for a file descriptor. An output for OUTPUT_MEMORY never writes anything: its
+    buffer grows to hold everything added, until it is taken out with consumeOutput.
+    @param *out the output to initialize
+    @param fd the file descriptor to write to, or OUTPUT_MEMORY
+ */
+void initOutput( Output *out, int fd );
+/**
+    Writes everything in the buffer to the file descriptor with as few write calls as it takes.
+    @param *out the output to flush
+ */
+void flushOutput( Output *out );
+/**
+    Removes bytes from the front of an output's buffer once they have been written out some other way.
+    @param *out the output
+    @param count the number of bytes written, no more than are in the buffer
+ */
+void consumeOutput( Output *out, size_t count );
+/**
+    Flushes an output and frees its buffer. The file descriptor is left open.
+    @param *out the output to free
+ */
+void freeOutput( Output *out );
+/**
+    Returns the number of bytes added to an output so far, whether or not they have been written yet.
+    @param *out the output
+    @return the number of bytes
+ */
+long long outputBytes( Output const *out );
+/**
+    Adds a run of bytes to the output. Runs longer than the buffer are written straight through.
+    @param *out the output to add to
+    @param *data the bytes
+    @param size the number of bytes
+ */
+void putBytes( Output *out, char const *data, size_t size );
+/**
+    Adds a character to the output.
+    @param *out the output to add to
+    @param ch the character
+ */
+void putChar( Output *out, char ch );
+/**
+    Adds a string to the output, like %s.
+    @param *out the output to add to
+    @param *str the string
+ */
+void putText( Output *out, char const *str );
+/**
+    Adds a string padded with spaces on the right to at least a width, like %-*s.
+    @param *out the output to add to
+    @param *str the string
+    @param width the smallest number of characters to add
+ */
+void putLeft( Output *out, char const *str, int width );
+/**
+    Adds an integer padded with spaces on the left to at least a width, like %*lld.
+    @param *out the output to add to
+    @param value the integer
+    @param width the smallest number of characters to add
+ */
+void putInt( Output *out, long long value, int width );
+/**
+    Adds an integer padded with spaces on the right to at least a width, like %-*lld.
+    @param *out the output to add to
+    @param value the integer
+    @param width the smallest number of characters to add
+ */
+void putIntLeft( Output *out, long long value, int width );
+/**
+    Adds formatted text to the output, the way printf would. This is for the odd line, rows of a report are
+    faster to build with the other functions.
+    @param *out the output to add to
+    @param *format the printf format
+ */
+void putFormat( Output *out, char const *format, ... );
+
+#endif
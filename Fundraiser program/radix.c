@@ -0,0 +1,93 @@
+/**
+    @file radix.c
+    @author Sachi Vyas (smvyas)
+    A program that: Sorts integer keys a byte at a time, so ordering a large list costs a few passes over it
+    and no calls to a comparison function.
+ */
+#include "radix.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+
+/** Number of bits in a byte of a key */
+#define BYTE_BITS 8
+/** Number of values a byte of a key can take */
+#define BYTE_VALUES 256
+/** Mask for one byte of a key */
+#define BYTE_MASK 0xFF
+/** Number of bytes in a key */
+#define KEY_BYTES 8
+
+/**
+    Allocates storage for a sort, exiting if there isn't any.
+    @param size the number of bytes needed
+    @return the storage
+ */
+static void *allocSort( size_t size )
+{
+    void *p = malloc(size == 0 ? 1 : size);
+    if (p == NULL) {
+        fprintf(stderr, "Memory allocation issue.\n");
+        exit(EXIT_FAILURE);
+    }
+    return p;
+}
+
+/**
+    Orders the positions of an array of 64-bit keys by key, with a least significant digit radix sort a byte
+    at a time. Positions with equal keys stay in increasing order, and bytes that are the same in every key
+    are skipped, so small keys cost only the passes they need.
+    @param *keys the keys
+    @param count the number of keys
+    @return a dynamically allocated array of count + 1 positions, in order of their keys
+ */
+int *radixOrder( unsigned long long const *keys, int count )
+{
+    // the counts for every byte are made in one read of the keys
+    size_t (*counts)[BYTE_VALUES] = allocSort(KEY_BYTES * sizeof(*counts));
+    memset(counts, 0, KEY_BYTES * sizeof(*counts));
+    for (int i = 0; i < count; i++) {
+        unsigned long long key = keys[i];
+        for (int b = 0; b < KEY_BYTES; b++) {
+            counts[b][(key >> (b * BYTE_BITS)) & BYTE_MASK]++;
+        }
+    }
+
+    unsigned long long *fromKeys = allocSort(count * sizeof(unsigned long long));
+    unsigned long long *toKeys = allocSort(count * sizeof(unsigned long long));
+    int *from = allocSort((count + 1) * sizeof(int));
+    int *to = allocSort((count + 1) * sizeof(int));
+    memcpy(fromKeys, keys, count * sizeof(unsigned long long));
+    for (int i = 0; i < count; i++) {
+        from[i] = i;
+    }
+    for (int b = 0; b < KEY_BYTES; b++) {
+        size_t *c = counts[b];
+        if (count == 0 || c[(keys[0] >> (b * BYTE_BITS)) & BYTE_MASK] == (size_t) count) {
+            continue;
+        }
+        size_t start = 0;
+        for (int v = 0; v < BYTE_VALUES; v++) {
+            size_t n = c[v];
+            c[v] = start;
+            start += n;
+        }
+        for (int i = 0; i < count; i++) {
+            size_t slot = c[(fromKeys[i] >> (b * BYTE_BITS)) & BYTE_MASK]++;
+            toKeys[slot] = fromKeys[i];
+            to[slot] = from[i];
+        }
+        unsigned long long *swapKeys = fromKeys;
+        fromKeys = toKeys;
+        toKeys = swapKeys;
+        int *swap = from;
+        from = to;
+        to = swap;
+    }
+    free(counts);
+    free(fromKeys);
+    free(toKeys);
+    free(to);
+    return from;
+}
@@ -0,0 +1,23 @@
+/**
+    @file radix.h
+    @author Sachi Vyas (smvyas)
+    A program that: The prototype for radix.c
+ */
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+
+#ifndef RADIX_H
+#define RADIX_H
+
+/**
+    Orders the positions of an array of 64-bit keys by key, with a least significant digit radix sort a byte
+    at a time. Positions with equal keys stay in increasing order, and bytes that are the same in every key
+    are skipped, so small keys cost only the passes they need.
+    @param *keys the keys
+    @param count the number of keys
+    @return a dynamically allocated array of count + 1 positions, in order of their keys
+ */
+int *radixOrder( unsigned long long const *keys, int count );
+
+#endif
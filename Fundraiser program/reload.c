@@ -0,0 +1,370 @@
+/**
+    @file reload.c
+    @author Sachi Vyas (smvyas)
+    A program that: Swaps a new item or member file into a running group without losing its sales. The file is
+    parsed, sorted and indexed into a group of its own, which can be done on another thread; only matching it
+    with the live group by id and swapping the new lists and indexes in is left for the thread making sales.
+ */
+#include "group.h"
+#include "reload.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+
+/** Marks an entry of one list with no entry of the same id in the other */
+#define NO_MATCH -1
+
+/**
+    Allocates storage for a reload, exiting if there isn't any.
+    @param size the number of bytes needed
+    @return the storage
+ */
+static void *allocReload( size_t size )
+{
+    void *p = malloc(size == 0 ? 1 : size);
+    if (p == NULL) {
+        fprintf(stderr, "Memory allocation issue.\n");
+        exit(EXIT_FAILURE);
+    }
+    return p;
+}
+
+/**
+    Frees a file read for a reload, along with whatever of it wasn't swapped into a group.
+    @param *reload the file read for the reload
+ */
+static void freeReload( Reload *reload )
+{
+    freeGroup(reload -> fresh);
+    free(reload);
+}
+
+/**
+    Reads an item or member file for a reload, with the same rules the program uses at the start, and sorts and
+    indexes it the same way. Nothing but the new group is touched, so this can run on any thread while
+    sales are being made.
+    @param members true for a member file, false for an item file
+    @param *filename the name of the file
+    @return the file read for the reload, or NULL if it couldn't be opened or isn't valid
+ */
+Reload *prepareReload( bool members, char const *filename )
+{
+    Group *fresh = makeGroup();
+    int status = members ? parseMembers(filename, fresh) : parseItems(filename, fresh);
+    if (status != FILE_READ) {
+        freeGroup(fresh);
+        return NULL;
+    }
+    if (members) {
+        sortMembersById(fresh);
+        fresh -> membersByName = makeMemberView(fresh, compareMembersByName);
+    }
+    else {
+        sortItemsById(fresh);
+        fresh -> itemsByName = makeItemView(fresh, compareItemsByName);
+    }
+    indexNames(fresh);
+    Reload *reload = allocReload(sizeof(Reload));
+    reload -> members = members;
+    reload -> fresh = fresh;
+    return reload;
+}
+
+/**
+    Matches up the entries of two lists sorted by the same keys, in one pass over both.
+    @param *oldKeys the keys of the group's list
+    @param oldCount the number of entries in the group's list
+    @param *newKeys the keys of the new list
+    @param count the number of entries in the new list
+    @param *from set to the position in the group's list of each new entry, or NO_MATCH
+    @param *to set to the position in the new list of each of the group's entries, or NO_MATCH
+ */
+static void matchKeys( unsigned long long const *oldKeys, int oldCount, unsigned long long const *newKeys, int count,
+                       int *from, int *to )
+{
+    int i = 0;
+    int j = 0;
+    while (i < oldCount || j < count) {
+        if (j == count || (i < oldCount && oldKeys[i] < newKeys[j])) {
+            to[i++] = NO_MATCH;
+        }
+        else if (i == oldCount || newKeys[j] < oldKeys[i]) {
+            from[j++] = NO_MATCH;
+        }
+        else {
+            to[i] = j;
+            from[j] = i;
+            i++;
+            j++;
+        }
+    }
+}
+
+/**
+    Matches the items of a group with the items of a new item list by id.
+    @param *group the group
+    @param *fresh the group holding the new item list
+    @param *from set to the position in the group of each new item, or NO_MATCH
+    @param *to set to the position in the new list of each of the group's items, or NO_MATCH
+ */
+static void matchItems( Group const *group, Group const *fresh, int *from, int *to )
+{
+    unsigned long long *oldKeys = allocReload(group -> iCount * sizeof(unsigned long long));
+    unsigned long long *newKeys = allocReload(fresh -> iCount * sizeof(unsigned long long));
+    // ids are positive, so they order the same as unsigned keys
+    for (int i = 0; i < group -> iCount; i++) {
+        oldKeys[i] = (unsigned long long) group -> itemIds[i];
+    }
+    for (int j = 0; j < fresh -> iCount; j++) {
+        newKeys[j] = (unsigned long long) fresh -> itemIds[j];
+    }
+    matchKeys(oldKeys, group -> iCount, newKeys, fresh -> iCount, from, to);
+    free(oldKeys);
+    free(newKeys);
+}
+
+/**
+    Matches the members of a group with the members of a new member list by id.
+    @param *group the group
+    @param *fresh the group holding the new member list
+    @param *from set to the position in the group of each new member, or NO_MATCH
+    @param *to set to the position in the new list of each of the group's members, or NO_MATCH
+ */
+static void matchMembers( Group const *group, Group const *fresh, int *from, int *to )
+{
+    unsigned long long *oldKeys = allocReload(group -> mCount * sizeof(unsigned long long));
+    unsigned long long *newKeys = allocReload(fresh -> mCount * sizeof(unsigned long long));
+    for (int i = 0; i < group -> mCount; i++) {
+        oldKeys[i] = group -> mList[i] -> idKey;
+    }
+    for (int j = 0; j < fresh -> mCount; j++) {
+        newKeys[j] = fresh -> mList[j] -> idKey;
+    }
+    matchKeys(oldKeys, group -> mCount, newKeys, fresh -> mCount, from, to);
+    free(oldKeys);
+    free(newKeys);
+}
+
+/**
+    Swaps a trigram index of a new list into a group, retiring the one it replaces.
+    @param *group the group
+    @param *live the group's index
+    @param *fresh the new index, left empty
+ */
+static void swapIndex( Group *group, TrigramIndex *live, TrigramIndex *fresh )
+{
+    retireStorage(group, live -> keys);
+    retireStorage(group, live -> starts);
+    retireStorage(group, live -> postings);
+    *live = *fresh;
+    fresh -> keyCount = 0;
+    fresh -> keys = NULL;
+    fresh -> starts = NULL;
+    fresh -> postings = NULL;
+}
+
+/**
+    Swaps a new item list into a group. The sold and revenue counts of the items that stay are carried over,
+    and the members' sales are moved to the new positions of their items.
+    @param *group the group
+    @param *fresh the group holding the new item list, whose columns and indexes are taken
+    @return false if an item that has been sold would be removed or change its cost, so nothing was changed
+ */
+static bool applyItems( Group *group, Group *fresh )
+{
+    int oldCount = group -> iCount;
+    int count = fresh -> iCount;
+    int *from = allocReload(count * sizeof(int));
+    int *to = allocReload(oldCount * sizeof(int));
+    matchItems(group, fresh, from, to);
+
+    // a sold item keeps its id and cost, or its sales would no longer add up
+    bool *sold = calloc(oldCount + 1, sizeof(bool));
+    if (sold == NULL) {
+        fprintf(stderr, "Memory allocation issue.\n");
+        exit(EXIT_FAILURE);
+    }
+    for (int m = 0; m < group -> mCount; m++) {
+        Member const *member = group -> mList[m];
+        for (int k = 0; k < member -> soldItemCount; k++) {
+            sold[member -> soldItems[k].itemIndex] = true;
+        }
+    }
+    bool keeps = true;
+    bool moved = count != oldCount;
+    for (int i = 0; i < oldCount; i++) {
+        if (sold[i] && (to[i] == NO_MATCH || fresh -> itemCosts[to[i]] != group -> itemCosts[i])) {
+            keeps = false;
+        }
+        if (to[i] != i) {
+            moved = true;
+        }
+    }
+    free(sold);
+
+    if (keeps) {
+        for (int j = 0; j < count; j++) {
+            if (from[j] != NO_MATCH) {
+                fresh -> itemSold[j] = group -> itemSold[from[j]];
+                fresh -> itemRevenue[j] = group -> itemRevenue[from[j]];
+            }
+        }
+        // both lists are in id order, so every sales list stays sorted by position
+        if (moved) {
+            for (int m = 0; m < group -> mCount; m++) {
+                Member *member = group -> mList[m];
+                for (int k = 0; k < member -> soldItemCount; k++) {
+                    member -> soldItems[k].itemIndex = to[member -> soldItems[k].itemIndex];
+                }
+            }
+        }
+        retireStorage(group, group -> itemIds);
+        retireStorage(group, group -> itemCosts);
+        retireStorage(group, group -> itemSold);
+        retireStorage(group, group -> itemRevenue);
+        retireStorage(group, group -> itemNamePool);
+        retireStorage(group, group -> iTable);
+        retireStorage(group, group -> itemsByName);
+        retireStorage(group, group -> itemsFolded);
+        group -> iCount = fresh -> iCount;
+        group -> iCap = fresh -> iCap;
+        group -> itemIds = fresh -> itemIds;
+        group -> itemCosts = fresh -> itemCosts;
+        group -> itemSold = fresh -> itemSold;
+        group -> itemRevenue = fresh -> itemRevenue;
+        group -> itemNamePool = fresh -> itemNamePool;
+        group -> iTable = fresh -> iTable;
+        group -> iTableCap = fresh -> iTableCap;
+        group -> itemsByName = fresh -> itemsByName;
+        group -> itemsFolded = fresh -> itemsFolded;
+        fresh -> iCount = 0;
+        fresh -> itemIds = NULL;
+        fresh -> itemCosts = NULL;
+        fresh -> itemSold = NULL;
+        fresh -> itemRevenue = NULL;
+        fresh -> itemNamePool = NULL;
+        fresh -> iTable = NULL;
+        fresh -> itemsByName = NULL;
+        fresh -> itemsFolded = NULL;
+        swapIndex(group, &group -> itemNames, &fresh -> itemNames);
+        swapIndex(group, &group -> foldedItemNames, &fresh -> foldedItemNames);
+    }
+    free(from);
+    free(to);
+    return keeps;
+}
+
+/**
+    Takes a member who is being removed out of the top seller ranking. The member whose node moves into its
+    slot is told the new slot, so that member's record is copied first if a view may be reading it.
+    @param *group the group
+    @param *m the member being removed
+ */
+static void dropSeller( Group *group, Member *m )
+{
+    int slot = m -> boardSlot;
+    Member *last = group -> sellers.nodes[group -> sellers.count - 1].member;
+    if (group -> versions != NULL && last != m) {
+        writableMember(group, last);
+    }
+    Member *moved = removeSeller(&group -> sellers, slot);
+    if (moved != NULL) {
+        moved -> boardSlot = slot;
+    }
+}
+
+/**
+    Swaps a new member list into a group. The members that stay keep their records, and so their sales and
+    their place in the ranking; new members get records in the group's arena.
+    @param *group the group
+    @param *fresh the group holding the new member list, whose indexes are taken
+    @return false if a member who has made sales would be removed, so nothing was changed
+ */
+static bool applyMembers( Group *group, Group *fresh )
+{
+    int oldCount = group -> mCount;
+    int count = fresh -> mCount;
+    int *from = allocReload(count * sizeof(int));
+    int *to = allocReload(oldCount * sizeof(int));
+    matchMembers(group, fresh, from, to);
+
+    // a member with sales stays, or the sales would no longer add up
+    bool keeps = true;
+    for (int i = 0; i < oldCount; i++) {
+        if (to[i] == NO_MATCH && group -> mList[i] -> soldItemCount > 0) {
+            keeps = false;
+        }
+    }
+
+    if (keeps) {
+        // records are written while the member list still matches the member index
+        for (int j = 0; j < count; j++) {
+            if (from[j] != NO_MATCH && strcmp(group -> mList[from[j]] -> name, fresh -> mList[j] -> name) != 0) {
+                Member *m = group -> mList[from[j]];
+                if (group -> versions != NULL) {
+                    m = writableMember(group, m);
+                }
+                strcpy(m -> name, fresh -> mList[j] -> name);
+            }
+        }
+        for (int i = 0; i < oldCount; i++) {
+            if (to[i] == NO_MATCH) {
+                dropSeller(group, group -> mList[i]);
+            }
+        }
+        Member **list = allocReload(fresh -> mCap * sizeof(Member *));
+        for (int j = 0; j < count; j++) {
+            if (from[j] != NO_MATCH) {
+                list[j] = group -> mList[from[j]];
+            }
+            else {
+                Member *m = (Member *)arenaAlloc(&group -> arena, sizeof(Member));
+                *m = *fresh -> mList[j];
+                m -> boardSlot = addSeller(&group -> sellers, m);
+                list[j] = m;
+            }
+        }
+        if (group -> versions != NULL) {
+            moveMemberStamps(group, from, count);
+        }
+        // views have their own copies of the member list
+        free(group -> mList);
+        retireStorage(group, group -> mTable);
+        retireStorage(group, group -> membersByName);
+        retireStorage(group, group -> membersFolded);
+        group -> mList = list;
+        group -> mCount = count;
+        group -> mCap = fresh -> mCap;
+        group -> mTable = fresh -> mTable;
+        group -> mTableCap = fresh -> mTableCap;
+        group -> membersByName = fresh -> membersByName;
+        group -> membersFolded = fresh -> membersFolded;
+        fresh -> mTable = NULL;
+        fresh -> membersByName = NULL;
+        fresh -> membersFolded = NULL;
+        swapIndex(group, &group -> memberNames, &fresh -> memberNames);
+        swapIndex(group, &group -> foldedMemberNames, &fresh -> foldedMemberNames);
+    }
+    free(from);
+    free(to);
+    return keeps;
+}
+
+/**
+    Swaps a file read by prepareReload into a group. Its items or members are matched with the group's by id:
+    new ones are added, missing ones are removed and the rest take their new names, and costs, while keeping
+    their sales. The new lists, name orders and indexes are swapped in whole, and the ones they replace are
+    freed once no view can be reading them. An item that has been sold can't be removed or change its cost,
+    and a member that has made sales can't be removed, so a reload that would do that changes nothing. The
+    reload is freed either way.
+    @param *group the group, which only the calling thread may be changing
+    @param *reload the file read for the reload
+    @return false if the reload would have lost or changed sales, so the group was left as it was
+ */
+bool applyReload( Group *group, Reload *reload )
+{
+    bool applied = reload -> members ? applyMembers(group, reload -> fresh) : applyItems(group, reload -> fresh);
+    freeReload(reload);
+    return applied;
+}
@@ -0,0 +1,47 @@
+/**
+    @file reload.h
+    @author Sachi Vyas (smvyas)
+    A program that: The prototype for reload.c
+ */
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+
+#ifndef RELOAD_H
+#define RELOAD_H
+
+struct GroupStruct;
+
+/**
+    Struct for an item or member file read for a reload: a group of its own holding just that file's items or
+    members, in id order, with their name orders and indexes built
+ */
+struct ReloadStruct {
+    bool members;
+    struct GroupStruct *fresh;
+};
+typedef struct ReloadStruct Reload;
+
+/**
+    Reads an item or member file for a reload, with the same rules the program uses at the start, and sorts and
+    indexes it the same way. Nothing but the new group is touched, so this can run on any thread while
+    sales are being made.
+    @param members true for a member file, false for an item file
+    @param *filename the name of the file
+    @return the file read for the reload, or NULL if it couldn't be opened or isn't valid
+ */
+Reload *prepareReload( bool members, char const *filename );
+/**
+    Swaps a file read by prepareReload into a group. Its items or members are matched with the group's by id:
+    new ones are added, missing ones are removed and the rest take their new names, and costs, while keeping
+    their sales. The new lists, name orders and indexes are swapped in whole, and the ones they replace are
+    freed once no view can be reading them. An item that has been sold can't be removed or change its cost,
+    and a member that has made sales can't be removed, so a reload that would do that changes nothing. The
+    reload is freed either way.
+    @param *group the group, which only the calling thread may be changing
+    @param *reload the file read for the reload
+    @return false if the reload would have lost or changed sales, so the group was left as it was
+ */
+bool applyReload( struct GroupStruct *group, Reload *reload );
+
+#endif
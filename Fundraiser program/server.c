@@ -0,0 +1,615 @@
+/**
+    @file server.c
+    @author Sachi Vyas (smvyas)
+    A program that: Serves many clients from one loaded group over a Unix domain socket. A single thread
+    runs an epoll event loop and every command that changes the group, one at a time. Lists and searches
+    are handed to a pool of reader threads, which run them on views of the group that sales don't change.
+    The reader threads also read the files of reloads, so the event loop only swaps the result in.
+ */
+#define _GNU_SOURCE
+#include "input.h"
+#include "group.h"
+#include "command.h"
+#include "reload.h"
+#include "server.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+/** Most events taken from epoll in one turn of the event loop */
+#define MAX_EVENTS 64
+/** Output a client may have waiting before the server stops running its commands until it catches up */
+#define HIGH_WATER 1048576
+/** Most reader threads the server starts */
+#define MAX_READERS 16
+
+/**
+    Struct for a connected client: its socket, the commands read from it and the output waiting for it. A
+    client waiting on a reader thread runs nothing else until the reader is done, so its output stays in
+    order, and a client that goes away meanwhile is only freed then.
+ */
+struct ClientStruct {
+    LineReader reader;
+    Output out;
+    Session session;
+    bool quit;
+    bool waiting;
+    bool gone;
+    int events;
+    char *readCmd;
+    struct ClientStruct *nextRead;
+    struct ClientStruct *prev;
+    struct ClientStruct *next;
+};
+typedef struct ClientStruct Client;
+
+/**
+    Struct for a command run by a reader thread, on a view of the group, with output and timings of its own.
+    A reload has no view: the reader only reads its file, and the event loop finishes it.
+ */
+struct JobStruct {
+    Client *client;
+    ReadView *view;
+    Reload *reload;
+    char *cmd;
+    Output out;
+    Stats stats;
+    struct JobStruct *next;
+};
+typedef struct JobStruct Job;
+
+/** Struct for the reader threads, the jobs waiting for them and the jobs they have finished */
+struct ReadersStruct {
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    Job *first;
+    Job *last;
+    Job *done;
+    int doneFd;
+    bool stopping;
+    int count;
+    pthread_t threads[MAX_READERS];
+};
+typedef struct ReadersStruct Readers;
+
+/** Struct for everything the event loop works with */
+struct ServerStruct {
+    int epfd;
+    Session const *base;
+    Client *clients;
+    Client *reads;
+    Readers readers;
+    long long bytesWritten;
+};
+typedef struct ServerStruct Server;
+
+/** Set by the signal handler when the server should stop */
+static volatile sig_atomic_t stopping = 0;
+
+/**
+    Notes that the server has been asked to stop.
+    @param sig the signal
+ */
+static void stopServer( int sig )
+{
+    (void) sig;
+    stopping = 1;
+}
+
+/**
+    Makes the socket a server listens on, replacing a socket file left behind by a server that is gone.
+    @param *path the path of the socket
+    @return the socket, or -1 if it couldn't be made
+ */
+static int listenOn( char const *path )
+{
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(addr.sun_path)) {
+        return -1;
+    }
+    strcpy(addr.sun_path, path);
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        return -1;
+    }
+    if (bind(fd, (struct sockaddr *) &addr, sizeof(addr)) != 0) {
+        // only take the path over from a socket nothing answers on any more
+        int probe = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        bool stale = errno == EADDRINUSE && probe >= 0 &&
+                     connect(probe, (struct sockaddr *) &addr, sizeof(addr)) != 0 && errno == ECONNREFUSED;
+        if (probe >= 0) {
+            close(probe);
+        }
+        struct stat st;
+        if (!stale || lstat(path, &st) != 0 || !S_ISSOCK(st.st_mode) || unlink(path) != 0 ||
+            bind(fd, (struct sockaddr *) &addr, sizeof(addr)) != 0) {
+            close(fd);
+            return -1;
+        }
+    }
+    if (listen(fd, SOMAXCONN) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/**
+    Runs the jobs handed to a reader thread until the server stops and no jobs are left.
+    @param *arg the readers
+    @return NULL
+ */
+static void *runReader( void *arg )
+{
+    Readers *readers = arg;
+    pthread_mutex_lock(&readers -> lock);
+    while (true) {
+        while (readers -> first == NULL && !readers -> stopping) {
+            pthread_cond_wait(&readers -> wake, &readers -> lock);
+        }
+        Job *job = readers -> first;
+        if (job == NULL) {
+            break;
+        }
+        readers -> first = job -> next;
+        if (readers -> first == NULL) {
+            readers -> last = NULL;
+        }
+        pthread_mutex_unlock(&readers -> lock);
+
+        if (job -> view == NULL) {
+            job -> reload = readReloadFile(job -> cmd);
+        }
+        else {
+            Session session;
+            initSession(&session, job -> view -> group, &job -> stats);
+            runCommand(&session, job -> cmd, &job -> out);
+        }
+
+        pthread_mutex_lock(&readers -> lock);
+        job -> next = readers -> done;
+        readers -> done = job;
+        uint64_t one = 1;
+        if (write(readers -> doneFd, &one, sizeof(one)) < 0) {
+            // the counter is already waking the event loop up
+        }
+    }
+    pthread_mutex_unlock(&readers -> lock);
+    return NULL;
+}
+
+/**
+    Starts the reader threads, one for each processor the event loop doesn't need.
+    @param *readers the readers to start
+    @return false if no reader could be started
+ */
+static bool startReaders( Readers *readers )
+{
+    pthread_mutex_init(&readers -> lock, NULL);
+    pthread_cond_init(&readers -> wake, NULL);
+    readers -> first = NULL;
+    readers -> last = NULL;
+    readers -> done = NULL;
+    readers -> stopping = false;
+    readers -> count = 0;
+    readers -> doneFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (readers -> doneFd < 0) {
+        return false;
+    }
+    long n = sysconf(_SC_NPROCESSORS_ONLN) - 1;
+    if (n > MAX_READERS) {
+        n = MAX_READERS;
+    }
+    do {
+        if (pthread_create(&readers -> threads[readers -> count], NULL, runReader, readers) != 0) {
+            break;
+        }
+        readers -> count++;
+    } while (readers -> count < n);
+    return readers -> count > 0;
+}
+
+/**
+    Sets which events epoll reports for a client: new input while its output is caught up and it isn't
+    waiting on a reader, and room to write while output is waiting. A client with nothing to watch for is
+    taken out of epoll, so its hangup isn't reported over and over.
+    @param *server the server
+    @param *client the client
+ */
+static void watchClient( Server *server, Client *client )
+{
+    int events = client -> out.len > 0 ? EPOLLOUT : client -> waiting ? 0 : EPOLLIN;
+    if (events != client -> events) {
+        struct epoll_event ev;
+        ev.events = events;
+        ev.data.ptr = client;
+        int op = client -> events == 0 ? EPOLL_CTL_ADD : events == 0 ? EPOLL_CTL_DEL : EPOLL_CTL_MOD;
+        epoll_ctl(server -> epfd, op, client -> reader.fd, &ev);
+        client -> events = events;
+    }
+}
+
+/**
+    Sends as much of a client's waiting output as its socket takes without blocking.
+    @param *client the client
+    @return false if the client has gone away
+ */
+static bool sendOutput( Client *client )
+{
+    while (client -> out.len > 0) {
+        ssize_t n = send(client -> reader.fd, client -> out.buffer, client -> out.len, MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n < 0) {
+            return errno == EAGAIN || errno == EWOULDBLOCK;
+        }
+        consumeOutput(&client -> out, n);
+    }
+    return true;
+}
+
+/**
+    Runs the commands a client has sent whole, until it quits, has too much output waiting or comes to a
+    list, search or reload. That command is set aside for a reader thread, and the client waits for it. When its
+    input has ended without a quit, the prompt is added the way it is at the end of standard input.
+    @param *server the server
+    @param *client the client
+    @return true if commands were left waiting because of the output
+ */
+static bool runCommands( Server *server, Client *client )
+{
+    char *cmd;
+    while (!client -> quit && !client -> waiting && client -> out.len < HIGH_WATER &&
+           (cmd = bufferedLine(&client -> reader)) != NULL) {
+        if (isReadOnly(cmd) || isReload(cmd)) {
+            client -> readCmd = strdup(cmd);
+            if (client -> readCmd == NULL) {
+                fprintf(stderr, "Memory allocation issue.\n");
+                exit(EXIT_FAILURE);
+            }
+            client -> waiting = true;
+            client -> nextRead = server -> reads;
+            server -> reads = client;
+        }
+        else {
+            client -> quit = runCommand(&client -> session, cmd, &client -> out);
+        }
+    }
+    if (!client -> quit && !client -> waiting && client -> reader.eof &&
+        client -> reader.start == client -> reader.end) {
+        putFormat(&client -> out, "cmd> ");
+        client -> quit = true;
+    }
+    return !client -> quit && !client -> waiting && client -> out.len >= HIGH_WATER;
+}
+
+/**
+    Waits for the sales made so far to be on disk, so no client is told of a sale a crash could still lose.
+    When nothing has been sold since the last time, this costs only a look at the journal.
+    @param *server the server
+ */
+static void syncSales( Server *server )
+{
+    // a journal that can't be written has said so, and the program fails when it ends
+    if (server -> base -> group -> journal != NULL) {
+        syncJournal(server -> base -> group -> journal);
+    }
+}
+
+/**
+    Runs what a client has sent and sends it the output, as long as the socket takes the output as fast as
+    it is made. The output is only sent once the sales in it are on disk.
+    @param *server the server
+    @param *client the client
+    @return false if the client has gone away
+ */
+static bool serveClient( Server *server, Client *client )
+{
+    bool more;
+    do {
+        more = runCommands(server, client);
+        syncSales(server);
+        if (!sendOutput(client)) {
+            return false;
+        }
+    } while (more && client -> out.len == 0);
+    return true;
+}
+
+/**
+    Disconnects a client and frees it. A client waiting on a reader thread is only disconnected, and is freed
+    when the reader is done.
+    @param *server the server, whose list of clients the client is taken out of and whose total output
+                   the client's output is added to
+    @param *client the client
+ */
+static void dropClient( Server *server, Client *client )
+{
+    if (!client -> gone) {
+        if (client -> events != 0) {
+            epoll_ctl(server -> epfd, EPOLL_CTL_DEL, client -> reader.fd, NULL);
+            client -> events = 0;
+        }
+        close(client -> reader.fd);
+        client -> gone = true;
+    }
+    if (client -> waiting) {
+        return;
+    }
+    if (client -> prev != NULL) {
+        client -> prev -> next = client -> next;
+    }
+    else {
+        server -> clients = client -> next;
+    }
+    if (client -> next != NULL) {
+        client -> next -> prev = client -> prev;
+    }
+    server -> bytesWritten += outputBytes(&client -> out);
+    freeLineReader(&client -> reader);
+    free(client -> out.buffer);
+    free(client);
+}
+
+/**
+    Serves a client after something happened to it, then drops it if it has gone away or quit and been sent
+    everything, or watches it for what it needs next.
+    @param *server the server
+    @param *client the client
+ */
+static void afterEvent( Server *server, Client *client )
+{
+    if (!serveClient(server, client) || (client -> quit && client -> out.len == 0)) {
+        dropClient(server, client);
+    }
+    else {
+        watchClient(server, client);
+    }
+}
+
+/**
+    Hands the lists, searches and reloads set aside this turn to the reader threads. Sales made earlier in the
+    turn are in the view a list or search runs on, so each client sees its own sales.
+    @param *server the server
+ */
+static void startReads( Server *server )
+{
+    Readers *readers = &server -> readers;
+    while (server -> reads != NULL) {
+        Client *client = server -> reads;
+        server -> reads = client -> nextRead;
+        Job *job = (Job *)malloc(sizeof(Job));
+        if (job == NULL) {
+            fprintf(stderr, "Memory allocation issue.\n");
+            exit(EXIT_FAILURE);
+        }
+        job -> client = client;
+        job -> view = isReload(client -> readCmd) ? NULL : acquireView(server -> base -> group);
+        job -> reload = NULL;
+        job -> cmd = client -> readCmd;
+        client -> readCmd = NULL;
+        initOutput(&job -> out, OUTPUT_MEMORY);
+        initStats(&job -> stats);
+        job -> next = NULL;
+        pthread_mutex_lock(&readers -> lock);
+        if (readers -> last != NULL) {
+            readers -> last -> next = job;
+        }
+        else {
+            readers -> first = job;
+        }
+        readers -> last = job;
+        pthread_cond_signal(&readers -> wake);
+        pthread_mutex_unlock(&readers -> lock);
+    }
+}
+
+/**
+    Takes the jobs the reader threads have finished, adds their output to their clients' and gives back
+    their views, then carries on with the clients. The file a reload read is swapped into the group here, on
+    the thread that makes every other change to it, while other clients' sales went on as it was read.
+    @param *server the server
+    @param serving false when the server is stopping, so the clients are only given their output
+ */
+static void finishReads( Server *server, bool serving )
+{
+    Readers *readers = &server -> readers;
+    uint64_t count;
+    if (read(readers -> doneFd, &count, sizeof(count)) < 0) {
+        // nothing more has been signalled since the last time
+    }
+    pthread_mutex_lock(&readers -> lock);
+    Job *job = readers -> done;
+    readers -> done = NULL;
+    pthread_mutex_unlock(&readers -> lock);
+    while (job != NULL) {
+        Job *next = job -> next;
+        Client *client = job -> client;
+        if (job -> view == NULL) {
+            finishReload(&client -> session, job -> cmd, job -> reload, &client -> out);
+        }
+        else {
+            putBytes(&client -> out, job -> out.buffer, job -> out.len);
+            if (server -> base -> stats != NULL) {
+                mergeStats(server -> base -> stats, &job -> stats);
+            }
+            releaseView(server -> base -> group, job -> view);
+        }
+        free(job -> cmd);
+        free(job -> out.buffer);
+        free(job);
+        client -> waiting = false;
+        if (client -> gone) {
+            dropClient(server, client);
+        }
+        else if (serving) {
+            afterEvent(server, client);
+        }
+        job = next;
+    }
+}
+
+/**
+    Stops the reader threads once they have run every job handed to them, and gives the clients the output
+    of the jobs without sending it.
+    @param *server the server
+ */
+static void stopReaders( Server *server )
+{
+    Readers *readers = &server -> readers;
+    pthread_mutex_lock(&readers -> lock);
+    readers -> stopping = true;
+    pthread_cond_broadcast(&readers -> wake);
+    pthread_mutex_unlock(&readers -> lock);
+    for (int i = 0; i < readers -> count; i++) {
+        pthread_join(readers -> threads[i], NULL);
+    }
+    finishReads(server, false);
+    close(readers -> doneFd);
+    pthread_mutex_destroy(&readers -> lock);
+    pthread_cond_destroy(&readers -> wake);
+}
+
+/**
+    Takes the new clients waiting on the listening socket.
+    @param *server the server, whose list of clients the new ones are added to
+    @param listener the listening socket
+ */
+static void acceptClients( Server *server, int listener )
+{
+    int fd;
+    while ((fd = accept4(listener, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC)) >= 0) {
+        Client *client = (Client *)malloc(sizeof(Client));
+        if (client == NULL) {
+            fprintf(stderr, "Memory allocation issue.\n");
+            exit(EXIT_FAILURE);
+        }
+        initLineReader(&client -> reader, fd);
+        initOutput(&client -> out, OUTPUT_MEMORY);
+        initSession(&client -> session, server -> base -> group, server -> base -> stats);
+        client -> quit = false;
+        client -> waiting = false;
+        client -> gone = false;
+        client -> events = 0;
+        client -> readCmd = NULL;
+        client -> nextRead = NULL;
+        client -> prev = NULL;
+        client -> next = server -> clients;
+        if (server -> clients != NULL) {
+            server -> clients -> prev = client;
+        }
+        server -> clients = client;
+        watchClient(server, client);
+    }
+}
+
+/**
+    Serves the command protocol on a Unix domain socket until the process is sent SIGINT or SIGTERM. Each
+    client gets a session of its own against the group, and the output a session on standard input would
+    give. Clients may send many commands without waiting; every command that has arrived whole is run, and
+    the output of all of them is sent together, once per turn of the event loop, after the sales of the turn
+    are committed to the journal together. Lists and searches run on
+    reader threads, against a view of the group taken after the sales before them, so a long listing
+    doesn't hold up other clients' sales.
+    @param *path the path of the socket, which is replaced if no server is listening on it
+    @param *base the session whose group and statistics the clients share
+    @param *bytesWritten set to the number of bytes of output made for all the clients
+    @return false if the socket couldn't be set up
+ */
+bool serve( char const *path, Session const *base, long long *bytesWritten )
+{
+    *bytesWritten = 0;
+    int listener = listenOn(path);
+    if (listener < 0) {
+        return false;
+    }
+    Server server;
+    server.epfd = epoll_create1(EPOLL_CLOEXEC);
+    server.base = base;
+    server.clients = NULL;
+    server.reads = NULL;
+    server.bytesWritten = 0;
+    struct epoll_event ev;
+    ev.events = EPOLLIN;
+    ev.data.ptr = NULL;
+    if (server.epfd < 0 || epoll_ctl(server.epfd, EPOLL_CTL_ADD, listener, &ev) != 0 ||
+        !startReaders(&server.readers)) {
+        if (server.epfd >= 0) {
+            close(server.epfd);
+        }
+        close(listener);
+        unlink(path);
+        return false;
+    }
+    ev.data.ptr = &server.readers;
+    epoll_ctl(server.epfd, EPOLL_CTL_ADD, server.readers.doneFd, &ev);
+    enableVersions(base -> group);
+
+    // no SA_RESTART, so a signal wakes epoll_wait up
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = stopServer;
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+
+    struct epoll_event events[MAX_EVENTS];
+    while (!stopping) {
+        int n = epoll_wait(server.epfd, events, MAX_EVENTS, -1);
+        bool readsDone = false;
+        for (int i = 0; i < n; i++) {
+            Client *client = events[i].data.ptr;
+            if (client == NULL) {
+                acceptClients(&server, listener);
+                continue;
+            }
+            if (events[i].data.ptr == &server.readers) {
+                readsDone = true;
+                continue;
+            }
+            if (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) {
+                // level triggered, so whatever isn't read now is reported again next turn
+                ssize_t got;
+                do {
+                    got = fillLineReader(&client -> reader);
+                } while (got > 0 && !client -> reader.eof);
+            }
+            runCommands(&server, client);
+        }
+        // the sales of every client this turn go to disk together, before any of them is sent its output
+        syncSales(&server);
+        for (int i = 0; i < n; i++) {
+            if (events[i].data.ptr != NULL && events[i].data.ptr != &server.readers) {
+                afterEvent(&server, events[i].data.ptr);
+            }
+        }
+        // finished reads can free their clients, so they wait until no more events for clients are left
+        if (readsDone) {
+            finishReads(&server, true);
+        }
+        startReads(&server);
+    }
+    stopReaders(&server);
+    while (server.clients != NULL) {
+        dropClient(&server, server.clients);
+    }
+    *bytesWritten = server.bytesWritten;
+    close(listener);
+    unlink(path);
+    close(server.epfd);
+    return true;
+}
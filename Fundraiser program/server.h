@@ -0,0 +1,29 @@
+/**
+    @file server.h
+    @author Sachi Vyas (smvyas)
+    A program that: The prototype for server.c
+ */
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+
+#ifndef SERVER_H
+#define SERVER_H
+
+#include "command.h"
+
+/**
+    Serves the command protocol on a Unix domain socket until the process is sent SIGINT or SIGTERM. Each
+    client gets a session of its own against the group, and the output a session on standard input would
+    give. Clients may send many commands without waiting; every command that has arrived whole is run, and
+    the output of all of them is sent together, once per turn of the event loop. Lists and searches run on
+    reader threads, against a view of the group taken after the sales before them, so a long listing
+    doesn't hold up other clients' sales.
+    @param *path the path of the socket, which is replaced if no server is listening on it
+    @param *base the session whose group and statistics the clients share
+    @param *bytesWritten set to the number of bytes of output made for all the clients
+    @return false if the socket couldn't be set up
+ */
+bool serve( char const *path, Session const *base, long long *bytesWritten );
+
+#endif
@@ -0,0 +1,572 @@
+/**
+    @file snapshot.c
+    @author Sachi Vyas (smvyas)
+    A program that: Saves a group as a binary image and loads it back by mapping the file into memory, so a
+    large group starts without parsing, sorting or indexing anything.
+ */
+#define _POSIX_C_SOURCE 200809L
+#include "input.h"
+#include "group.h"
+#include "snapshot.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+#include <stdint.h>
+
+/** Marks the start of a snapshot file */
+#define SNAPSHOT_MAGIC "FRSNAP\r\n"
+/** Length of SNAPSHOT_MAGIC */
+#define MAGIC_LEN 8
+/** Version of the snapshot layout, raised whenever it changes */
+#define SNAPSHOT_VERSION 4
+/** Alignment of each section of a snapshot */
+#define SECTION_ALIGN 16
+/** Size of the buffer a snapshot is written through, a multiple of the checksum word */
+#define WRITE_BUFFER_SIZE 65536
+/** Shift that packs each record size into the layout check */
+#define LAYOUT_SHIFT 8
+/** Suffix of the temporary file a snapshot is written to */
+#define TEMP_SUFFIX ".tmp"
+/** Shift that mixes the two halves of the checksum */
+#define CHECKSUM_SHIFT 32
+
+/** The sections of a snapshot, in the order they are written */
+enum SnapshotSection {
+    SEC_ITEM_IDS,
+    SEC_ITEM_COSTS,
+    SEC_ITEM_SOLD,
+    SEC_ITEM_REVENUE,
+    SEC_ITEM_NAMES,
+    SEC_MEMBERS,
+    SEC_SALES,
+    SEC_ITEM_TABLE,
+    SEC_MEMBER_TABLE,
+    SEC_ITEMS_BY_NAME,
+    SEC_MEMBERS_BY_NAME,
+    SEC_ITEMS_FOLDED,
+    SEC_MEMBERS_FOLDED,
+    SEC_INDEXES,
+    SNAPSHOT_SECTIONS = SEC_INDEXES + 4 * 3
+};
+
+/** The three sections of each trigram index, following SEC_INDEXES */
+enum IndexPart {
+    PART_KEYS,
+    PART_STARTS,
+    PART_POSTINGS,
+    INDEX_PARTS
+};
+
+/** Number of trigram indexes in a group */
+#define INDEX_COUNT 4
+
+/** Struct for where a section lies in a snapshot */
+struct SectionStruct {
+    unsigned long long offset;
+    unsigned long long size;
+};
+typedef struct SectionStruct Section;
+
+/** Struct for the header at the start of a snapshot */
+struct SnapshotHeaderStruct {
+    char magic[MAGIC_LEN];
+    unsigned int version;
+    unsigned int layout;
+    int iCount;
+    int mCount;
+    int iTableCap;
+    int mTableCap;
+    int keyCounts[INDEX_COUNT];
+    unsigned long long journalId;
+    long long journalRecords;
+    unsigned long long payloadSize;
+    unsigned long long checksum;
+    Section sections[SNAPSHOT_SECTIONS];
+};
+typedef struct SnapshotHeaderStruct SnapshotHeader;
+
+/** Struct for a snapshot being written, with the running checksum of what has been written */
+struct SnapshotWriterStruct {
+    FILE *fp;
+    char buffer[WRITE_BUFFER_SIZE];
+    size_t len;
+    unsigned long long offset;
+    unsigned long long sumLow;
+    unsigned long long sumHigh;
+    bool ok;
+};
+typedef struct SnapshotWriterStruct SnapshotWriter;
+
+/**
+    Rounds a size up to the alignment of a section.
+    @param size the size
+    @return the rounded size
+ */
+static unsigned long long alignSection( unsigned long long size )
+{
+    return (size + SECTION_ALIGN - 1) & ~(unsigned long long)(SECTION_ALIGN - 1);
+}
+
+/**
+    Describes the sizes of the records in a snapshot, so a program built with a different layout rejects it.
+    @return the sizes packed into one number
+ */
+static unsigned int recordLayout( void )
+{
+    return (unsigned int)(NAME_SLOT | sizeof(Member) << LAYOUT_SHIFT | sizeof(SaleItem) << (2 * LAYOUT_SHIFT) |
+                          sizeof(void *) << (3 * LAYOUT_SHIFT));
+}
+
+/**
+    Adds whole 64-bit words to a running checksum. It is a Fletcher style sum: one total of the words and one
+    total of the running totals, so it notices changed, missing and reordered words.
+    @param *data the words, which may be unaligned
+    @param size the number of bytes, a multiple of eight
+    @param *low the running total of the words
+    @param *high the running total of the totals
+ */
+static void addToChecksum( char const *data, size_t size, unsigned long long *low, unsigned long long *high )
+{
+    unsigned long long a = *low;
+    unsigned long long b = *high;
+    for (size_t i = 0; i < size; i += sizeof(unsigned long long)) {
+        unsigned long long word;
+        memcpy(&word, data + i, sizeof(word));
+        a += word;
+        b += a;
+    }
+    *low = a;
+    *high = b;
+}
+
+/**
+    Combines the two halves of a checksum.
+    @param low the running total of the words
+    @param high the running total of the totals
+    @return the checksum
+ */
+static unsigned long long finishChecksum( unsigned long long low, unsigned long long high )
+{
+    return high ^ (low << CHECKSUM_SHIFT | low >> CHECKSUM_SHIFT);
+}
+
+/**
+    Writes out what is waiting in a writer's buffer and adds it to the checksum.
+    @param *w the writer
+ */
+static void flushWriter( SnapshotWriter *w )
+{
+    addToChecksum(w -> buffer, w -> len, &w -> sumLow, &w -> sumHigh);
+    if (fwrite(w -> buffer, 1, w -> len, w -> fp) != w -> len) {
+        w -> ok = false;
+    }
+    w -> len = 0;
+}
+
+/**
+    Adds bytes to a snapshot.
+    @param *w the writer
+    @param *data the bytes
+    @param size the number of bytes
+ */
+static void writeBytes( SnapshotWriter *w, void const *data, size_t size )
+{
+    char const *p = data;
+    while (size > 0) {
+        size_t n = WRITE_BUFFER_SIZE - w -> len;
+        if (n > size) {
+            n = size;
+        }
+        memcpy(w -> buffer + w -> len, p, n);
+        w -> len += n;
+        w -> offset += n;
+        p += n;
+        size -= n;
+        if (w -> len == WRITE_BUFFER_SIZE) {
+            flushWriter(w);
+        }
+    }
+}
+
+/**
+    Adds zero bytes to a snapshot.
+    @param *w the writer
+    @param size the number of zero bytes
+ */
+static void writeZeros( SnapshotWriter *w, size_t size )
+{
+    static char const zeros[SECTION_ALIGN];
+    while (size > 0) {
+        size_t n = size < SECTION_ALIGN ? size : SECTION_ALIGN;
+        writeBytes(w, zeros, n);
+        size -= n;
+    }
+}
+
+/**
+    Ends a section, recording where it lies and padding the file out to where the next section starts.
+    @param *w the writer
+    @param *section filled in with the place and size of the section
+    @param start the offset the section started at
+ */
+static void endSection( SnapshotWriter *w, Section *section, unsigned long long start )
+{
+    section -> offset = start;
+    section -> size = w -> offset - start;
+    writeZeros(w, alignSection(w -> offset) - w -> offset);
+}
+
+/**
+    Writes an array as a section of its own.
+    @param *w the writer
+    @param *header the header to record the section in
+    @param which the section
+    @param *data the array
+    @param size the size of the array in bytes
+ */
+static void writeSection( SnapshotWriter *w, SnapshotHeader *header, int which, void const *data, size_t size )
+{
+    unsigned long long start = w -> offset;
+    writeBytes(w, data, size);
+    endSection(w, &header -> sections[which], start);
+}
+
+/**
+    Returns the four trigram indexes of a group, in the order they are saved.
+    @param *group the group
+    @param *indexes filled in with pointers to the indexes
+ */
+static void groupIndexes( struct GroupStruct const *group, TrigramIndex const **indexes )
+{
+    indexes[0] = &group -> itemNames;
+    indexes[1] = &group -> memberNames;
+    indexes[2] = &group -> foldedItemNames;
+    indexes[3] = &group -> foldedMemberNames;
+}
+
+/**
+    Writes a binary image of a group to a file: the items, the members with their sales, the indexes and the
+    name orders, behind a header with a version and a checksum. The header also notes which journal the group
+    has and how many of its sales the image holds, so they aren't replayed twice; those sales are committed to
+    the journal first, so the journal never holds fewer. The image is written to a temporary file that
+    replaces the named one only once it is complete.
+    @param *group the group to save
+    @param *filename the file to save it in
+    @return false if the file couldn't be written
+ */
+bool saveSnapshot( Group const *group, char const *filename )
+{
+    if (group -> journal != NULL && !syncJournal(group -> journal)) {
+        return false;
+    }
+    char *temp = (char *)malloc(strlen(filename) + sizeof(TEMP_SUFFIX));
+    SnapshotWriter *w = (SnapshotWriter *)malloc(sizeof(SnapshotWriter));
+    if (temp == NULL || w == NULL) {
+        fprintf(stderr, "Memory allocation issue.\n");
+        exit(EXIT_FAILURE);
+    }
+    strcpy(temp, filename);
+    strcat(temp, TEMP_SUFFIX);
+    w -> fp = fopen(temp, "wb");
+    if (w -> fp == NULL) {
+        free(temp);
+        free(w);
+        return false;
+    }
+
+    SnapshotHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, SNAPSHOT_MAGIC, MAGIC_LEN);
+    header.version = SNAPSHOT_VERSION;
+    header.layout = recordLayout();
+    header.iCount = group -> iCount;
+    header.mCount = group -> mCount;
+    header.iTableCap = group -> iTableCap;
+    header.mTableCap = group -> mTableCap;
+    header.journalId = group -> journalId;
+    header.journalRecords = group -> journalRecords;
+
+    // the header is written last, once the checksum of everything after it is known
+    unsigned long long headerSize = alignSection(sizeof(SnapshotHeader));
+    w -> ok = fseek(w -> fp, (long) headerSize, SEEK_SET) == 0;
+    w -> len = 0;
+    w -> offset = headerSize;
+    w -> sumLow = 0;
+    w -> sumHigh = 0;
+
+    writeSection(w, &header, SEC_ITEM_IDS, group -> itemIds, group -> iCount * sizeof(int));
+    writeSection(w, &header, SEC_ITEM_COSTS, group -> itemCosts, group -> iCount * sizeof(int));
+    writeSection(w, &header, SEC_ITEM_SOLD, group -> itemSold, group -> iCount * sizeof(long long));
+    writeSection(w, &header, SEC_ITEM_REVENUE, group -> itemRevenue, group -> iCount * sizeof(long long));
+    writeSection(w, &header, SEC_ITEM_NAMES, group -> itemNamePool, (size_t) group -> iCount * NAME_SLOT);
+
+    // a member's sales pointer and leaderboard slot are set again when it is loaded
+    unsigned long long start = w -> offset;
+    for (int i = 0; i < group -> mCount; i++) {
+        Member m = *group -> mList[i];
+        m.soldItems = NULL;
+        m.boardSlot = 0;
+        writeBytes(w, &m, sizeof(Member));
+    }
+    endSection(w, &header.sections[SEC_MEMBERS], start);
+
+    // each member's sales keep their whole power-of-two block, so they can keep growing where they are
+    start = w -> offset;
+    for (int i = 0; i < group -> mCount; i++) {
+        Member const *m = group -> mList[i];
+        writeBytes(w, m -> soldItems, m -> soldItemCount * sizeof(SaleItem));
+        writeZeros(w, (m -> soldItemCap - m -> soldItemCount) * sizeof(SaleItem));
+    }
+    endSection(w, &header.sections[SEC_SALES], start);
+
+    writeSection(w, &header, SEC_ITEM_TABLE, group -> iTable, group -> iTableCap * sizeof(int));
+    writeSection(w, &header, SEC_MEMBER_TABLE, group -> mTable, group -> mTableCap * sizeof(int));
+    writeSection(w, &header, SEC_ITEMS_BY_NAME, group -> itemsByName, group -> iCount * sizeof(int));
+    writeSection(w, &header, SEC_MEMBERS_BY_NAME, group -> membersByName, group -> mCount * sizeof(int));
+    writeSection(w, &header, SEC_ITEMS_FOLDED, group -> itemsFolded, (size_t)(group -> iCount + 1) * FOLD_SLOT);
+    writeSection(w, &header, SEC_MEMBERS_FOLDED, group -> membersFolded, (size_t)(group -> mCount + 1) * FOLD_SLOT);
+
+    TrigramIndex const *indexes[INDEX_COUNT];
+    groupIndexes(group, indexes);
+    for (int i = 0; i < INDEX_COUNT; i++) {
+        TrigramIndex const *index = indexes[i];
+        int first = SEC_INDEXES + i * INDEX_PARTS;
+        header.keyCounts[i] = index -> keyCount;
+        writeSection(w, &header, first + PART_KEYS, index -> keys, index -> keyCount * sizeof(unsigned int));
+        writeSection(w, &header, first + PART_STARTS, index -> starts, (index -> keyCount + 1) * sizeof(int));
+        writeSection(w, &header, first + PART_POSTINGS, index -> postings,
+                     index -> starts[index -> keyCount] * sizeof(int));
+    }
+    flushWriter(w);
+
+    header.payloadSize = w -> offset - headerSize;
+    header.checksum = finishChecksum(w -> sumLow, w -> sumHigh);
+    bool ok = w -> ok && fseek(w -> fp, 0, SEEK_SET) == 0 && fwrite(&header, sizeof(header), 1, w -> fp) == 1;
+    ok = fclose(w -> fp) == 0 && ok;
+    ok = ok && rename(temp, filename) == 0;
+    if (!ok) {
+        remove(temp);
+    }
+    free(temp);
+    free(w);
+    return ok;
+}
+
+/**
+    Checks that a section lies inside the payload of a snapshot, is aligned, and has the size expected.
+    @param *header the header of the snapshot
+    @param fileSize the size of the snapshot file
+    @param which the section
+    @param size the size the section should be
+    @return true if the section is sound
+ */
+static bool checkSection( SnapshotHeader const *header, size_t fileSize, int which, unsigned long long size )
+{
+    Section const *s = &header -> sections[which];
+    return s -> offset % SECTION_ALIGN == 0 && s -> offset >= alignSection(sizeof(SnapshotHeader)) &&
+           s -> offset <= fileSize && s -> size == size && s -> size <= fileSize - s -> offset;
+}
+
+/**
+    Checks that every entry of an int array from a snapshot is in a range.
+    @param *values the array
+    @param count the number of entries
+    @param low the smallest allowed value
+    @param high one more than the largest allowed value
+    @return true if every entry is in range
+ */
+static bool checkRange( int const *values, long long count, int low, int high )
+{
+    for (long long i = 0; i < count; i++) {
+        if (values[i] < low || values[i] >= high) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+    Checks the fixed part of a snapshot: its header, its checksum and the size of each section that doesn't
+    depend on the sales or the trigram indexes.
+    @param *file the mapped snapshot
+    @return true if it is sound
+ */
+static bool checkHeader( MappedFile const *file )
+{
+    SnapshotHeader const *header = (SnapshotHeader const *) file -> data;
+    unsigned long long headerSize = alignSection(sizeof(SnapshotHeader));
+    if (file -> size < headerSize || memcmp(header -> magic, SNAPSHOT_MAGIC, MAGIC_LEN) != 0 ||
+        header -> version != SNAPSHOT_VERSION || header -> layout != recordLayout() ||
+        header -> payloadSize != file -> size - headerSize || header -> payloadSize % sizeof(unsigned long long) != 0) {
+        return false;
+    }
+    unsigned long long low = 0;
+    unsigned long long high = 0;
+    addToChecksum(file -> data + headerSize, header -> payloadSize, &low, &high);
+    if (finishChecksum(low, high) != header -> checksum) {
+        return false;
+    }
+    int iCount = header -> iCount;
+    int mCount = header -> mCount;
+    if (iCount < 0 || mCount < 0 || header -> iTableCap <= iCount || header -> mTableCap <= mCount ||
+        (header -> iTableCap & (header -> iTableCap - 1)) != 0 ||
+        (header -> mTableCap & (header -> mTableCap - 1)) != 0) {
+        return false;
+    }
+    size_t size = file -> size;
+    return checkSection(header, size, SEC_ITEM_IDS, (unsigned long long) iCount * sizeof(int)) &&
+           checkSection(header, size, SEC_ITEM_COSTS, (unsigned long long) iCount * sizeof(int)) &&
+           checkSection(header, size, SEC_ITEM_SOLD, (unsigned long long) iCount * sizeof(long long)) &&
+           checkSection(header, size, SEC_ITEM_REVENUE, (unsigned long long) iCount * sizeof(long long)) &&
+           checkSection(header, size, SEC_ITEM_NAMES, (unsigned long long) iCount * NAME_SLOT) &&
+           checkSection(header, size, SEC_MEMBERS, (unsigned long long) mCount * sizeof(Member)) &&
+           checkSection(header, size, SEC_ITEM_TABLE, (unsigned long long) header -> iTableCap * sizeof(int)) &&
+           checkSection(header, size, SEC_MEMBER_TABLE, (unsigned long long) header -> mTableCap * sizeof(int)) &&
+           checkSection(header, size, SEC_ITEMS_BY_NAME, (unsigned long long) iCount * sizeof(int)) &&
+           checkSection(header, size, SEC_MEMBERS_BY_NAME, (unsigned long long) mCount * sizeof(int)) &&
+           checkSection(header, size, SEC_ITEMS_FOLDED, (unsigned long long)(iCount + 1) * FOLD_SLOT) &&
+           checkSection(header, size, SEC_MEMBERS_FOLDED, (unsigned long long)(mCount + 1) * FOLD_SLOT);
+}
+
+/**
+    Points a trigram index at its sections of a snapshot, after checking them.
+    @param *file the mapped snapshot
+    @param *index the index to set up
+    @param which the number of the index, from 0 to INDEX_COUNT - 1
+    @param count the number of names in the index
+    @return true if the index's sections are sound
+ */
+static bool mapIndex( MappedFile const *file, TrigramIndex *index, int which, int count )
+{
+    SnapshotHeader const *header = (SnapshotHeader const *) file -> data;
+    int first = SEC_INDEXES + which * INDEX_PARTS;
+    int keyCount = header -> keyCounts[which];
+    if (keyCount < 0 ||
+        !checkSection(header, file -> size, first + PART_KEYS, (unsigned long long) keyCount * sizeof(unsigned int)) ||
+        !checkSection(header, file -> size, first + PART_STARTS, (unsigned long long)(keyCount + 1) * sizeof(int))) {
+        return false;
+    }
+    int const *starts = (int const *)(file -> data + header -> sections[first + PART_STARTS].offset);
+    int postingCount = starts[keyCount];
+    if (starts[0] != 0 || postingCount < 0 ||
+        !checkSection(header, file -> size, first + PART_POSTINGS, (unsigned long long) postingCount * sizeof(int))) {
+        return false;
+    }
+    for (int k = 0; k < keyCount; k++) {
+        if (starts[k] > starts[k + 1]) {
+            return false;
+        }
+    }
+    index -> keyCount = keyCount;
+    index -> keys = (unsigned int *)(file -> data + header -> sections[first + PART_KEYS].offset);
+    index -> starts = (int *) starts;
+    index -> postings = (int *)(file -> data + header -> sections[first + PART_POSTINGS].offset);
+    return checkRange(index -> postings, postingCount, 0, count);
+}
+
+/**
+    Makes a group from a file written by saveSnapshot. The file is mapped into memory as a private copy and
+    the group uses its records and indexes where they lie, so loading costs little more than reading the file
+    once to check it.
+    @param *filename the file to load
+    @return the group, or NULL if the file couldn't be read or isn't a valid snapshot
+ */
+Group *loadSnapshot( char const *filename )
+{
+    MappedFile file;
+    if (!mapFileCopy(filename, &file)) {
+        return NULL;
+    }
+    if (!checkHeader(&file)) {
+        unmapFile(&file);
+        return NULL;
+    }
+    SnapshotHeader const *header = (SnapshotHeader const *) file.data;
+    char *base = (char *) file.data;
+    Group *group = makeGroup();
+    group -> snapshot = file.data;
+    group -> snapshotSize = file.size;
+    group -> snapshotRead = file.read;
+
+    // the item columns and member records stay where they are in the mapping, only the member list is made
+    free(group -> itemIds);
+    free(group -> itemCosts);
+    free(group -> itemSold);
+    free(group -> itemRevenue);
+    free(group -> itemNamePool);
+    group -> iCount = header -> iCount;
+    group -> iCap = header -> iCount;
+    group -> itemIds = (int *)(base + header -> sections[SEC_ITEM_IDS].offset);
+    group -> itemCosts = (int *)(base + header -> sections[SEC_ITEM_COSTS].offset);
+    group -> itemSold = (long long *)(base + header -> sections[SEC_ITEM_SOLD].offset);
+    group -> itemRevenue = (long long *)(base + header -> sections[SEC_ITEM_REVENUE].offset);
+    group -> itemNamePool = base + header -> sections[SEC_ITEM_NAMES].offset;
+    group -> mCount = header -> mCount;
+    group -> mCap = header -> mCount > 0 ? header -> mCount : 1;
+    free(group -> mList);
+    group -> mList = (Member **)malloc(group -> mCap * sizeof(Member *));
+    if (group -> mList == NULL) {
+        fprintf(stderr, "Memory allocation issue.\n");
+        exit(EXIT_FAILURE);
+    }
+    Member *members = (Member *)(base + header -> sections[SEC_MEMBERS].offset);
+    SaleItem *sales = (SaleItem *)(base + header -> sections[SEC_SALES].offset);
+    unsigned long long salesLeft = header -> sections[SEC_SALES].size / sizeof(SaleItem);
+    bool ok = header -> sections[SEC_SALES].size % sizeof(SaleItem) == 0 &&
+              checkSection(header, file.size, SEC_SALES, header -> sections[SEC_SALES].size);
+    for (int i = 0; i < group -> mCount && ok; i++) {
+        Member *m = &members[i];
+        int cap = m -> soldItemCap;
+        ok = m -> soldItemCount >= 0 && m -> soldItemCount <= cap && (cap == 0 || cap >= INITIAL_SALES) &&
+             (cap & (cap - 1)) == 0 && (unsigned long long) cap <= salesLeft &&
+             memchr(m -> memberId, '\0', sizeof(m -> memberId)) != NULL &&
+             memchr(m -> name, '\0', sizeof(m -> name)) != NULL && m -> idKey == packMemberId(m -> memberId);
+        if (ok) {
+            m -> soldItems = cap > 0 ? sales : NULL;
+            for (int j = 0; j < m -> soldItemCount && ok; j++) {
+                ok = sales[j].itemIndex >= 0 && sales[j].itemIndex < group -> iCount &&
+                     (j == 0 || sales[j - 1].itemIndex < sales[j].itemIndex);
+            }
+            sales += cap;
+            salesLeft -= cap;
+            group -> mList[i] = m;
+            m -> boardSlot = addSeller(&group -> sellers, m);
+            addRevenue(&group -> sellers, m -> boardSlot, m -> revenue);
+        }
+    }
+    for (int i = 0; i < group -> iCount && ok; i++) {
+        ok = memchr(itemName(group, i), '\0', NAME_SLOT) != NULL;
+    }
+    group -> journalId = header -> journalId;
+    group -> journalRecords = header -> journalRecords;
+
+    // the indexes and name orders hold no pointers, so they are used straight from the mapping, where an
+    // empty slot of a hash index is -1
+    free(group -> iTable);
+    free(group -> mTable);
+    group -> iTable = (int *)(base + header -> sections[SEC_ITEM_TABLE].offset);
+    group -> iTableCap = header -> iTableCap;
+    group -> mTable = (int *)(base + header -> sections[SEC_MEMBER_TABLE].offset);
+    group -> mTableCap = header -> mTableCap;
+    group -> itemsByName = (int *)(base + header -> sections[SEC_ITEMS_BY_NAME].offset);
+    group -> membersByName = (int *)(base + header -> sections[SEC_MEMBERS_BY_NAME].offset);
+    group -> itemsFolded = base + header -> sections[SEC_ITEMS_FOLDED].offset;
+    group -> membersFolded = base + header -> sections[SEC_MEMBERS_FOLDED].offset;
+    ok = ok && checkRange(group -> iTable, group -> iTableCap, -1, group -> iCount) &&
+         checkRange(group -> mTable, group -> mTableCap, -1, group -> mCount) &&
+         checkRange(group -> itemsByName, group -> iCount, 0, group -> iCount) &&
+         checkRange(group -> membersByName, group -> mCount, 0, group -> mCount);
+
+    TrigramIndex *indexes[INDEX_COUNT] = {
+        &group -> itemNames, &group -> memberNames, &group -> foldedItemNames, &group -> foldedMemberNames
+    };
+    for (int i = 0; i < INDEX_COUNT && ok; i++) {
+        ok = mapIndex(&file, indexes[i], i, i % 2 == 0 ? group -> iCount : group -> mCount);
+    }
+    if (!ok) {
+        freeGroup(group);
+        return NULL;
+    }
+    return group;
+}
@@ -0,0 +1,35 @@
+/**
+    @file snapshot.h
+    @author Sachi Vyas (smvyas)
+    A program that: The prototype for snapshot.c
+ */
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+struct GroupStruct;
+
+/**
+    Writes a binary image of a group to a file: the items, the members with their sales, the indexes and the
+    name orders, behind a header with a version and a checksum. The header also notes which journal the group
+    has and how many of its sales the image holds, so they aren't replayed twice; those sales are committed to
+    the journal first, so the journal never holds fewer. The image is written to a temporary file that
+    replaces the named one only once it is complete.
+    @param *group the group to save
+    @param *filename the file to save it in
+    @return false if the file couldn't be written
+ */
+bool saveSnapshot( struct GroupStruct const *group, char const *filename );
+/**
+    Makes a group from a file written by saveSnapshot. The file is mapped into memory as a private copy and
+    the group uses its records and indexes where they lie, so loading costs little more than reading the file
+    once to check it.
+    @param *filename the file to load
+    @return the group, or NULL if the file couldn't be read or isn't a valid snapshot
+ */
+struct GroupStruct *loadSnapshot( char const *filename );
+
+#endif
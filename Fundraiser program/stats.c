@@ -0,0 +1,180 @@
+/**
+    @file stats.c
+    @author Sachi Vyas (smvyas)
+    A program that: Keeps latency histograms for each kind of command and counts of what the program did,
+    and reports them as a table or as JSON.
+ */
+#define _POSIX_C_SOURCE 200809L
+#include "stats.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+
+/** Nanoseconds in a second */
+#define NANOS_PER_SECOND 1000000000LL
+/** Nanoseconds in a microsecond */
+#define NANOS_PER_MICRO 1000.0
+/** Percent for the median */
+#define MEDIAN 50
+/** Percent for the tail latency that is reported */
+#define TAIL 99
+/** Percent for the whole */
+#define PERCENT 100
+/** Position of the highest bit of a long long */
+#define TOP_BIT 63
+
+/** Names of the kinds of command, in the order of enum CommandKind */
+static char const *const commandNames[COMMAND_KINDS] = {
+    "quit", "sale", "load sales", "save snapshot", "reload", "list items", "list item names", "list members",
+    "list member names", "list topsellers", "list member", "search item", "search member", "search ignorecase item",
+    "search ignorecase member", "stats", "invalid"
+};
+
+/**
+    Initializes the statistics with every count at zero.
+    @param *stats the statistics to initialize
+ */
+void initStats( Stats *stats )
+{
+    memset(stats, 0, sizeof(Stats));
+}
+
+/**
+    Returns the time from a clock that only goes forward.
+    @return the time in nanoseconds
+ */
+long long statsNow( void )
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * NANOS_PER_SECOND + ts.tv_nsec;
+}
+
+/**
+    Finds the histogram bucket for a time: bucket b holds times from 2^b up to 2^(b+1) nanoseconds.
+    @param nanos the time
+    @return the bucket
+ */
+static int bucketOf( long long nanos )
+{
+    if (nanos <= 1) {
+        return 0;
+    }
+    int b = TOP_BIT - __builtin_clzll((unsigned long long) nanos);
+    return b < LATENCY_BUCKETS ? b : LATENCY_BUCKETS - 1;
+}
+
+/**
+    Records how long one command took, in its histogram and totals.
+    @param *stats the statistics
+    @param kind the kind of command
+    @param nanos how long it took in nanoseconds
+ */
+void recordCommand( Stats *stats, enum CommandKind kind, long long nanos )
+{
+    CommandStats *c = &stats -> commands[kind];
+    c -> count++;
+    c -> totalNanos += nanos;
+    if (nanos > c -> maxNanos) {
+        c -> maxNanos = nanos;
+    }
+    c -> buckets[bucketOf(nanos)]++;
+}
+
+/**
+    Adds the counts and timings of one set of statistics to another.
+    @param *stats the statistics to add to
+    @param *more the statistics to add
+ */
+void mergeStats( Stats *stats, Stats const *more )
+{
+    for (int k = 0; k < COMMAND_KINDS; k++) {
+        CommandStats *c = &stats -> commands[k];
+        CommandStats const *m = &more -> commands[k];
+        c -> count += m -> count;
+        c -> totalNanos += m -> totalNanos;
+        if (m -> maxNanos > c -> maxNanos) {
+            c -> maxNanos = m -> maxNanos;
+        }
+        for (int b = 0; b < LATENCY_BUCKETS; b++) {
+            c -> buckets[b] += m -> buckets[b];
+        }
+    }
+    stats -> salesApplied += more -> salesApplied;
+    stats -> invalidCommands += more -> invalidCommands;
+}
+
+/**
+    Estimates a percentile of a kind's times from its histogram, as the top of the bucket it falls in.
+    @param *c the timings of the kind
+    @param percent the percentile
+    @return the estimate in nanoseconds, never more than the longest time seen
+ */
+static long long percentile( CommandStats const *c, int percent )
+{
+    long long rank = (c -> count * percent + PERCENT - 1) / PERCENT;
+    long long seen = 0;
+    for (int b = 0; b < LATENCY_BUCKETS; b++) {
+        seen += c -> buckets[b];
+        if (seen >= rank) {
+            long long top = (2LL << b) - 1;
+            return top < c -> maxNanos ? top : c -> maxNanos;
+        }
+    }
+    return c -> maxNanos;
+}
+
+/**
+    Prints a table of the statistics for the stats command: for each kind of command that has run, how
+    many times it ran and its mean, median, 99th percentile and longest time, then the other counts.
+    @param *stats the statistics
+    @param bytesWritten the number of bytes of output so far
+    @param *out the output to print to
+ */
+void printStats( Stats const *stats, long long bytesWritten, Output *out )
+{
+    putFormat(out, "%-24s %10s %10s %10s %10s %10s\n", "Command", "Count", "Mean us", "p50 us", "p99 us",
+              "Max us");
+    for (int k = 0; k < COMMAND_KINDS; k++) {
+        CommandStats const *c = &stats -> commands[k];
+        if (c -> count == 0) {
+            continue;
+        }
+        putFormat(out, "%-24s %10lld %10.1f %10.1f %10.1f %10.1f\n", commandNames[k], c -> count,
+                  c -> totalNanos / NANOS_PER_MICRO / c -> count, percentile(c, MEDIAN) / NANOS_PER_MICRO,
+                  percentile(c, TAIL) / NANOS_PER_MICRO, c -> maxNanos / NANOS_PER_MICRO);
+    }
+    putFormat(out, "Sales applied: %lld\n", stats -> salesApplied);
+    putFormat(out, "Invalid commands: %lld\n", stats -> invalidCommands);
+    putFormat(out, "Bytes written: %lld\n\n", bytesWritten);
+}
+
+/**
+    Writes the statistics, with every histogram bucket, to a file as one JSON object.
+    @param *stats the statistics
+    @param bytesWritten the number of bytes of output so far
+    @param *filename the file to write
+    @return false if the file couldn't be written
+ */
+bool dumpStats( Stats const *stats, long long bytesWritten, char const *filename )
+{
+    FILE *fp = fopen(filename, "w");
+    if (fp == NULL) {
+        return false;
+    }
+    fprintf(fp, "{\"sales_applied\": %lld, \"invalid_commands\": %lld, \"bytes_written\": %lld, \"commands\": {",
+            stats -> salesApplied, stats -> invalidCommands, bytesWritten);
+    for (int k = 0; k < COMMAND_KINDS; k++) {
+        CommandStats const *c = &stats -> commands[k];
+        fprintf(fp, "%s\n  \"%s\": {\"count\": %lld, \"total_ns\": %lld, \"max_ns\": %lld, \"buckets\": [",
+                k == 0 ? "" : ",", commandNames[k], c -> count, c -> totalNanos, c -> maxNanos);
+        for (int b = 0; b < LATENCY_BUCKETS; b++) {
+            fprintf(fp, "%s%lld", b == 0 ? "" : ", ", c -> buckets[b]);
+        }
+        fprintf(fp, "]}");
+    }
+    fprintf(fp, "\n}}\n");
+    return fclose(fp) == 0;
+}
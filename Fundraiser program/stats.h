@@ -0,0 +1,117 @@
+/**
+    @file stats.h
+    @author Sachi Vyas (smvyas)
+    A program that: The prototype for stats.c
+ */
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+
+#ifndef STATS_H
+#define STATS_H
+
+#include "output.h"
+
+/** Number of latency buckets, one for each power of two nanoseconds */
+#define LATENCY_BUCKETS 48
+
+/** The kinds of command that are timed separately */
+enum CommandKind {
+    CMD_QUIT,
+    CMD_SALE,
+    CMD_LOAD_SALES,
+    CMD_SAVE_SNAPSHOT,
+    CMD_RELOAD,
+    CMD_LIST_ITEMS,
+    CMD_LIST_ITEM_NAMES,
+    CMD_LIST_MEMBERS,
+    CMD_LIST_MEMBER_NAMES,
+    CMD_LIST_TOPSELLERS,
+    CMD_LIST_MEMBER,
+    CMD_SEARCH_ITEM,
+    CMD_SEARCH_MEMBER,
+    CMD_SEARCH_IGNORECASE_ITEM,
+    CMD_SEARCH_IGNORECASE_MEMBER,
+    CMD_STATS,
+    CMD_INVALID,
+    COMMAND_KINDS
+};
+
+/** Struct for the timings of one kind of command */
+struct CommandStatsStruct {
+    long long count;
+    long long totalNanos;
+    long long maxNanos;
+    long long buckets[LATENCY_BUCKETS];
+};
+typedef struct CommandStatsStruct CommandStats;
+
+/** Struct for everything counted about a run of the program */
+struct StatsStruct {
+    CommandStats commands[COMMAND_KINDS];
+    long long salesApplied;
+    long long invalidCommands;
+};
+typedef struct StatsStruct Stats;
+
+/*
+    The command loop uses these macros rather than calling the functions, so building with -DNO_STATS
+    removes the timing and counting entirely.
+ */
+#ifndef NO_STATS
+/** Notes the time a command starts */
+#define STATS_START( start ) long long start = statsNow()
+/** Records how long a command took, from the time noted by STATS_START */
+#define STATS_RECORD( stats, kind, start ) recordCommand( stats, kind, statsNow() - (start) )
+/** Counts a command that was rejected as invalid */
+#define STATS_INVALID( stats ) ((stats) -> invalidCommands++)
+/** Counts sales that were applied to the group */
+#define STATS_SALES( stats, count ) ((stats) -> salesApplied += (count))
+#else
+#define STATS_START( start ) ((void) 0)
+#define STATS_RECORD( stats, kind, start ) ((void) (kind))
+#define STATS_INVALID( stats ) ((void) 0)
+#define STATS_SALES( stats, count ) ((void) 0)
+#endif
+
+/**
+    Initializes the statistics with every count at zero.
+    @param *stats the statistics to initialize
+ */
+void initStats( Stats *stats );
+/**
+    Returns the time from a clock that only goes forward.
+    @return the time in nanoseconds
+ */
+long long statsNow( void );
+/**
+    Records how long one command took, in its histogram and totals.
+    @param *stats the statistics
+    @param kind the kind of command
+    @param nanos how long it took in nanoseconds
+ */
+void recordCommand( Stats *stats, enum CommandKind kind, long long nanos );
+/**
+    Adds the counts and timings of one set of statistics to another.
+    @param *stats the statistics to add to
+    @param *more the statistics to add
+ */
+void mergeStats( Stats *stats, Stats const *more );
+/**
+    Prints a table of the statistics for the stats command: for each kind of command that has run, how
+    many times it ran and its mean, median, 99th percentile and longest time, then the other counts.
+    @param *stats the statistics
+    @param bytesWritten the number of bytes of output so far
+    @param *out the output to print to
+ */
+void printStats( Stats const *stats, long long bytesWritten, Output *out );
+/**
+    Writes the statistics, with every histogram bucket, to a file as one JSON object.
+    @param *stats the statistics
+    @param bytesWritten the number of bytes of output so far
+    @param *filename the file to write
+    @return false if the file couldn't be written
+ */
+bool dumpStats( Stats const *stats, long long bytesWritten, char const *filename );
+
+#endif
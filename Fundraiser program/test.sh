@@ -39,9 +39,43 @@ runTest() {
   return 0
 }
 
+# Function to run a test through the server.  Starts ./fundraiser with the
+# arguments in args and --serve, sends input-NN.txt with ./client and expects
+# the output of the same test on standard input.
+runServerTest() {
+  TESTNO=$1
+
+  rm -f output.txt stderr.txt test.sock
+
+  echo "Server test $TESTNO: ./fundraiser ${args[@]} --serve test.sock; ./client test.sock < input-$TESTNO.txt > output.txt"
+  ./fundraiser ${args[@]} --serve test.sock 2> stderr.txt &
+  SPID=$!
+  # the client tries again until the server is listening
+  ./client test.sock < input-$TESTNO.txt > output.txt
+  STATUS=$?
+  kill $SPID 2>/dev/null
+  wait $SPID 2>/dev/null
+  rm -f test.sock
+
+  if [ $STATUS -ne 0 ]; then
+      echo "**** FAILED - The client couldn't talk to the server"
+      FAIL=1
+      return 1
+  fi
+
+  if ! diff -q expected-$TESTNO.txt output.txt >/dev/null 2>&1 ; then
+      echo "**** FAILED - output to the client didn't match expected."
+      FAIL=1
+      return 1
+  fi
+
+  echo "PASS"
+  return 0
+}
+
 # Try to get a fresh compile of the project.
 make clean
-make
+make fundraiser client
 if [ $? -ne 0 ]; then
     echo "**** Make didn't run succesfully when trying to build your program."
     FAIL=1
@@ -108,6 +142,97 @@ if [ -x fundraiser ] ; then
  
     args=(items-h.txt members-b.txt)
     runTest 20 1
+
+    args=(items-c.txt members-c.txt)
+    runTest 21 0
+
+    args=(items-c.txt members-c.txt)
+    runTest 22 0
+
+    args=(items-c.txt members-c.txt)
+    runTest 23 0
+
+    args=(--snapshot snapshot-23.bin)
+    runTest 24 0
+
+    args=(--snapshot items-c.txt)
+    runTest 25 1
+
+    # test 27 replays the journal test 26 writes
+    rm -f journal-26.bin
+    args=(items-c.txt members-c.txt --journal journal-26.bin)
+    runTest 26 0
+
+    args=(items-c.txt members-c.txt --journal journal-26.bin)
+    runTest 27 0
+
+    args=(items-c.txt members-c.txt)
+    runTest 28 0
+
+    args=(items-i.txt members-c.txt)
+    runTest 29 0
+
+    args=(items-c.txt members-c.txt)
+    runTest 30 0
+
+    # the item file comes through a pipe, which can't be mapped
+    rm -f items-fifo
+    mkfifo items-fifo
+    cat items-c.txt > items-fifo &
+    args=(items-fifo members-c.txt)
+    runTest 31 0
+    kill $! 2>/dev/null
+    rm -f items-fifo
+
+    args=(items-c.txt members-c.txt --jornal journal-32.bin)
+    runTest 32 1
+
+    # a snapshot saved while a sale waits in the journal's pending batch, then a crash
+    rm -f input-fifo journal-33.bin snapshot-33.bin
+    mkfifo input-fifo
+    FUNDRAISER_JOURNAL_MS=100000 ./fundraiser items-c.txt members-c.txt --journal journal-33.bin \
+        < input-fifo > /dev/null 2>&1 &
+    pid=$!
+    exec 3> input-fifo
+    printf 'sale dk 435 2\nsave snapshot snapshot-33.bin\n' >&3
+    for i in $(seq 50); do
+        [ -f snapshot-33.bin ] && break
+        sleep 0.1
+    done
+    kill -9 $pid 2>/dev/null
+    wait $pid 2>/dev/null
+    exec 3>&-
+    rm -f input-fifo
+
+    # test 34 replays the sales test 33 adds after the snapshot
+    args=(--snapshot snapshot-33.bin --journal journal-33.bin)
+    runTest 33 0
+
+    args=(--snapshot snapshot-33.bin --journal journal-33.bin)
+    runTest 34 0
+
+    # a journal holding fewer sales than the snapshot says isn't the one it was saved with
+    head -c 16 journal-33.bin > journal-35.bin
+    args=(--snapshot snapshot-33.bin --journal journal-35.bin)
+    runTest 35 1
+
+    # the same commands sent by a client of the server get the same output
+    for t in 03 07 10 21 22 28 30; do
+        args=(items-c.txt members-c.txt)
+        runServerTest $t
+    done
+
+    args=(items-c.txt members-c.txt)
+    runTest ec-01 0
+
+    args=(items-c.txt members-c.txt)
+    runTest ec-02 0
+
+    args=(items-c.txt members-c.txt)
+    runTest ec-03 0
+
+    args=(items-c.txt members-c.txt)
+    runTest ec-04 0
  
 else
     echo "**** Your program couldn't be tested since it didn't compile successfully."
@@ -0,0 +1,234 @@
+/**
+    @file trigram.c
+    @author Sachi Vyas (smvyas)
+    A program that: Indexes names by the three character sequences in them, so a substring search only has
+    to check the names that contain every trigram of the search string.
+ */
+#include "trigram.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+
+/** Number of bits in a byte of a trigram */
+#define BYTE_BITS 8
+/** Number of values a byte of a trigram can take */
+#define BYTE_VALUES 256
+/** Mask for one byte of a key */
+#define BYTE_MASK 0xFF
+/** Shift that puts the trigram above the name position in a sort key */
+#define KEY_SHIFT 32
+
+/**
+    Packs the three characters at the start of a string into a trigram.
+    @param *s the characters
+    @return the trigram
+ */
+static unsigned int trigramAt( char const *s )
+{
+    unsigned char const *u = (unsigned char const *) s;
+    return (unsigned int) u[0] << (2 * BYTE_BITS) | (unsigned int) u[1] << BYTE_BITS | u[2];
+}
+
+/**
+    Allocates storage for an index, exiting if there isn't any.
+    @param size the number of bytes needed
+    @return the storage
+ */
+static void *allocIndex( size_t size )
+{
+    void *p = malloc(size == 0 ? 1 : size);
+    if (p == NULL) {
+        fprintf(stderr, "Memory allocation issue.\n");
+        exit(EXIT_FAILURE);
+    }
+    return p;
+}
+
+/**
+    Builds the index for a list of names. Each trigram gets a posting list of the positions of the names that
+    contain it, in increasing order.
+    @param *index the index to build
+    @param **names the names to index
+    @param count the number of names
+ */
+void buildTrigramIndex( TrigramIndex *index, char const *const *names, int count )
+{
+    size_t total = 0;
+    for (int i = 0; i < count; i++) {
+        size_t len = strlen(names[i]);
+        if (len >= TRIGRAM_LEN) {
+            total += len - TRIGRAM_LEN + 1;
+        }
+    }
+
+    // one (trigram, position) key for every trigram of every name, made in position order
+    unsigned long long *pairs = allocIndex(total * sizeof(unsigned long long));
+    unsigned long long *sorted = allocIndex(total * sizeof(unsigned long long));
+    size_t k = 0;
+    for (int i = 0; i < count; i++) {
+        size_t len = strlen(names[i]);
+        for (size_t j = 0; j + TRIGRAM_LEN <= len; j++) {
+            pairs[k++] = (unsigned long long) trigramAt(names[i] + j) << KEY_SHIFT | (unsigned int) i;
+        }
+    }
+
+    // a stable radix sort on the trigram bytes keeps the positions for each trigram in increasing order
+    for (int pass = 0; pass < TRIGRAM_LEN; pass++) {
+        int shift = KEY_SHIFT + pass * BYTE_BITS;
+        size_t counts[BYTE_VALUES + 1] = { 0 };
+        for (size_t j = 0; j < total; j++) {
+            counts[((pairs[j] >> shift) & BYTE_MASK) + 1]++;
+        }
+        for (int b = 0; b < BYTE_VALUES; b++) {
+            counts[b + 1] += counts[b];
+        }
+        for (size_t j = 0; j < total; j++) {
+            sorted[counts[(pairs[j] >> shift) & BYTE_MASK]++] = pairs[j];
+        }
+        unsigned long long *swap = pairs;
+        pairs = sorted;
+        sorted = swap;
+    }
+
+    // collapse repeats of a trigram within one name, and lay the lists out one after another
+    index -> keys = allocIndex(total * sizeof(unsigned int));
+    index -> starts = allocIndex((total + 1) * sizeof(int));
+    index -> postings = allocIndex(total * sizeof(int));
+    index -> keyCount = 0;
+    int postingCount = 0;
+    for (size_t j = 0; j < total; j++) {
+        if (j > 0 && pairs[j] == pairs[j - 1]) {
+            continue;
+        }
+        unsigned int key = (unsigned int)(pairs[j] >> KEY_SHIFT);
+        if (index -> keyCount == 0 || index -> keys[index -> keyCount - 1] != key) {
+            index -> keys[index -> keyCount] = key;
+            index -> starts[index -> keyCount] = postingCount;
+            index -> keyCount++;
+        }
+        index -> postings[postingCount++] = (int)(pairs[j] & 0xFFFFFFFFu);
+    }
+    index -> starts[index -> keyCount] = postingCount;
+    free(pairs);
+    free(sorted);
+}
+
+/**
+    Frees the storage used by an index.
+    @param *index the index to free
+ */
+void freeTrigramIndex( TrigramIndex *index )
+{
+    free(index -> keys);
+    free(index -> starts);
+    free(index -> postings);
+    index -> keys = NULL;
+    index -> starts = NULL;
+    index -> postings = NULL;
+    index -> keyCount = 0;
+}
+
+/**
+    Finds the posting list for a trigram with a binary search of the keys.
+    @param *index the index to search
+    @param key the trigram
+    @return the number of the key, or -1 if no name contains the trigram
+ */
+static int findKey( TrigramIndex const *index, unsigned int key )
+{
+    int lo = 0;
+    int hi = index -> keyCount;
+    while (lo < hi) {
+        int mid = lo + (hi - lo) / 2;
+        if (index -> keys[mid] < key) {
+            lo = mid + 1;
+        }
+        else {
+            hi = mid;
+        }
+    }
+    return lo < index -> keyCount && index -> keys[lo] == key ? lo : -1;
+}
+
+/**
+    Finds the first posting at or after a cursor that isn't less than a position.
+    @param *postings the postings
+    @param lo the cursor to start from
+    @param hi the end of the posting list
+    @param pos the position to look for
+    @return the first posting in [lo, hi) that is at least pos, or hi
+ */
+static int lowerBound( int const *postings, int lo, int hi, int pos )
+{
+    while (lo < hi) {
+        int mid = lo + (hi - lo) / 2;
+        if (postings[mid] < pos) {
+            lo = mid + 1;
+        }
+        else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+/**
+    Finds the names that contain every trigram of a search string, by intersecting their posting lists. Every
+    name containing the string is found, but a name can contain all the trigrams without containing the string,
+    so candidates still need to be checked.
+    @param *index the index to search
+    @param *str the search string, at least TRIGRAM_LEN characters long
+    @param **candidates set to a dynamically allocated array of the positions found, in increasing order
+    @return the number of positions found
+ */
+int findCandidates( TrigramIndex const *index, char const *str, int **candidates )
+{
+    int n = strlen(str) - TRIGRAM_LEN + 1;
+    int *cursor = allocIndex(n * sizeof(int));
+    int *ends = allocIndex(n * sizeof(int));
+    int shortest = 0;
+    for (int t = 0; t < n; t++) {
+        int key = findKey(index, trigramAt(str + t));
+        if (key < 0) {
+            free(cursor);
+            free(ends);
+            *candidates = allocIndex(0);
+            return 0;
+        }
+        cursor[t] = index -> starts[key];
+        ends[t] = index -> starts[key + 1];
+        if (ends[t] - cursor[t] < ends[shortest] - cursor[shortest]) {
+            shortest = t;
+        }
+    }
+
+    // walk the shortest list, moving a cursor through each of the others
+    int *found = allocIndex((ends[shortest] - cursor[shortest]) * sizeof(int));
+    int count = 0;
+    bool done = false;
+    for (int j = cursor[shortest]; j < ends[shortest] && !done; j++) {
+        int pos = index -> postings[j];
+        bool inAll = true;
+        for (int t = 0; t < n && inAll; t++) {
+            if (t == shortest) {
+                continue;
+            }
+            cursor[t] = lowerBound(index -> postings, cursor[t], ends[t], pos);
+            if (cursor[t] == ends[t]) {
+                done = true;
+                inAll = false;
+            }
+            else if (index -> postings[cursor[t]] != pos) {
+                inAll = false;
+            }
+        }
+        if (inAll) {
+            found[count++] = pos;
+        }
+    }
+    free(cursor);
+    free(ends);
+    *candidates = found;
+    return count;
+}
@@ -0,0 +1,49 @@
+/**
+    @file trigram.h
+    @author Sachi Vyas (smvyas)
+    A program that: The prototype for trigram.c
+ */
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+
+#ifndef TRIGRAM_H
+#define TRIGRAM_H
+
+/** Shortest search string the trigram index can answer, shorter ones need a scan */
+#define TRIGRAM_LEN 3
+
+/** Struct for an inverted index from each three character sequence to the names that contain it */
+struct TrigramIndexStruct {
+    int keyCount;
+    unsigned int *keys;
+    int *starts;
+    int *postings;
+};
+typedef struct TrigramIndexStruct TrigramIndex;
+
+/**
+    Builds the index for a list of names. Each trigram gets a posting list of the positions of the names that
+    contain it, in increasing order.
+    @param *index the index to build
+    @param **names the names to index
+    @param count the number of names
+ */
+void buildTrigramIndex( TrigramIndex *index, char const *const *names, int count );
+/**
+    Frees the storage used by an index.
+    @param *index the index to free
+ */
+void freeTrigramIndex( TrigramIndex *index );
+/**
+    Finds the names that contain every trigram of a search string, by intersecting their posting lists. Every
+    name containing the string is found, but a name can contain all the trigrams without containing the string,
+    so candidates still need to be checked.
+    @param *index the index to search
+    @param *str the search string, at least TRIGRAM_LEN characters long
+    @param **candidates set to a dynamically allocated array of the positions found, in increasing order
+    @return the number of positions found
+ */
+int findCandidates( TrigramIndex const *index, char const *str, int **candidates );
+
+#endif
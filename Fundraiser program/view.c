@@ -0,0 +1,527 @@
+/**
+    @file view.c
+    @author Sachi Vyas (smvyas)
+    A program that: Gives commands that only read a group unchanging views of it, RCU style. A view is a copy
+    of the group's item totals, its member list and its leaderboard, made once per change of the group. Sales never
+    write a record a view can see: they write a copy, and the old record is reused once the views that can
+    see it are given back. The copies of a view that was given back are reused for a later view, which only
+    copies the chunks of each array written in between, so a sale costs the next view a few chunks rather
+    than a copy of everything.
+ */
+#include "group.h"
+#include "view.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+
+/** Smallest block arenaBlock hands out */
+#define SMALLEST_BLOCK 16
+/** Log2 of the number of items in a chunk of the item columns */
+#define ITEM_CHUNK_SHIFT 10
+/** Log2 of the number of members in a chunk of the member list */
+#define MEMBER_CHUNK_SHIFT 8
+/** Log2 of the number of nodes in a chunk of the leaderboard, which a sale writes all along a path */
+#define SELLER_CHUNK_SHIFT 6
+
+/**
+    Allocates storage for a view or a list, exiting if there isn't any.
+    @param size the number of bytes needed
+    @return the storage
+ */
+static void *allocView( size_t size )
+{
+    void *p = malloc(size == 0 ? 1 : size);
+    if (p == NULL) {
+        fprintf(stderr, "Memory allocation issue.\n");
+        exit(EXIT_FAILURE);
+    }
+    return p;
+}
+
+/**
+    Rounds a record size up to a block size arenaBlock hands out.
+    @param size the size of the record
+    @return the size of the block to copy it into
+ */
+static size_t blockSize( size_t size )
+{
+    size_t block = SMALLEST_BLOCK;
+    while (block < size) {
+        block *= DOUBLE_SIZE;
+    }
+    return block;
+}
+
+/**
+    Starts keeping track of which chunks of an array are written, with none of them written yet.
+    @param *c the changes to initialize
+    @param count the number of entries in the array
+    @param shift log2 of the number of entries in a chunk
+ */
+static void initChanges( Changes *c, int count, int shift )
+{
+    c -> shift = shift;
+    c -> chunks = (count >> shift) + 1;
+    c -> stamps = calloc(c -> chunks, sizeof(long long));
+    if (c -> stamps == NULL) {
+        fprintf(stderr, "Memory allocation issue.\n");
+        exit(EXIT_FAILURE);
+    }
+}
+
+/**
+    Stamps the chunk holding an entry of an array as written now. An entry past the chunks tracked so far
+    grows them, and the new chunks count as written too.
+    @param *c the changes to the array
+    @param index the position of the entry
+    @param stamp the number of the newest view
+ */
+static void noteChange( Changes *c, int index, long long stamp )
+{
+    int chunk = index >> c -> shift;
+    if (chunk >= c -> chunks) {
+        int chunks = c -> chunks * DOUBLE_SIZE > chunk ? c -> chunks * DOUBLE_SIZE : chunk + 1;
+        long long *stamps = realloc(c -> stamps, chunks * sizeof(long long));
+        if (stamps == NULL) {
+            fprintf(stderr, "Memory allocation issue.\n");
+            exit(EXIT_FAILURE);
+        }
+        for (int i = c -> chunks; i < chunks; i++) {
+            stamps[i] = stamp;
+        }
+        c -> stamps = stamps;
+        c -> chunks = chunks;
+    }
+    c -> stamps[chunk] = stamp;
+}
+
+/**
+    Brings a copy of one of the group's arrays up to date. If the copy is the same length as the array and
+    was right for view since, only the chunks written after that view are copied; otherwise all of it is.
+    @param *copy the copy, or NULL if there isn't one yet
+    @param copyCount the number of entries in the copy
+    @param *live the group's array
+    @param count the number of entries in the group's array
+    @param size the size of an entry
+    @param *c the changes to the group's array
+    @param since the number of the view the copy was right for, or 0 if it must be copied whole
+    @return the copy, which is new if the old one was the wrong length
+ */
+static void *refreshCopy( void *copy, int copyCount, void const *live, int count, size_t size, Changes const *c,
+                          long long since )
+{
+    if (copy == NULL || copyCount != count) {
+        free(copy);
+        copy = allocView(count * size);
+        since = 0;
+    }
+    if (since == 0) {
+        memcpy(copy, live, count * size);
+        return copy;
+    }
+    size_t chunkSize = (size_t) 1 << c -> shift;
+    for (int i = 0; i < c -> chunks; i++) {
+        size_t start = (size_t) i << c -> shift;
+        if (start >= (size_t) count) {
+            break;
+        }
+        if (c -> stamps[i] >= since) {
+            size_t n = count - start < chunkSize ? count - start : chunkSize;
+            memcpy((char *) copy + start * size, (char const *) live + start * size, n * size);
+        }
+    }
+    return copy;
+}
+
+/**
+    Stamps the chunk of the leaderboard holding a node that is about to be written. This is the hook of the
+    group's leaderboard while it keeps views.
+    @param *arg the versions of the group
+    @param slot the node
+ */
+static void sellerChanging( void *arg, int slot )
+{
+    Versions *v = arg;
+    noteChange(&v -> sellers, slot, v -> published);
+}
+
+/**
+    Starts keeping views of a group, so commands that only read can run on other threads while sales
+    are made. Only the thread making sales may call the functions of this file.
+    @param *group the group
+ */
+void enableVersions( Group *group )
+{
+    Versions *v = allocView(sizeof(Versions));
+    v -> published = 0;
+    v -> memberStamps = calloc(group -> mCount + 1, sizeof(long long));
+    if (v -> memberStamps == NULL) {
+        fprintf(stderr, "Memory allocation issue.\n");
+        exit(EXIT_FAILURE);
+    }
+    v -> current = NULL;
+    v -> oldest = NULL;
+    v -> newest = NULL;
+    v -> retired = NULL;
+    v -> retiredCount = 0;
+    v -> retiredCap = 0;
+    initChanges(&v -> items, group -> iCount, ITEM_CHUNK_SHIFT);
+    initChanges(&v -> members, group -> mCount, MEMBER_CHUNK_SHIFT);
+    initChanges(&v -> sellers, group -> sellers.count, SELLER_CHUNK_SHIFT);
+    v -> reshaped = 0;
+    v -> spareCount = 0;
+    group -> sellers.changing = sellerChanging;
+    group -> sellers.changingArg = v;
+    group -> versions = v;
+}
+
+/**
+    Frees a view and its copies of the group.
+    @param *view the view
+ */
+static void freeCopies( ReadView *view )
+{
+    free(view -> group -> itemSold);
+    free(view -> group -> itemRevenue);
+    free(view -> group -> mList);
+    free(view -> group -> sellers.nodes);
+    free(view -> group);
+    free(view);
+}
+
+/**
+    Keeps a view nothing holds any more as a spare, in place of the oldest spare once there are enough.
+    @param *v the versions of the group
+    @param *view the view
+ */
+static void keepSpare( Versions *v, ReadView *view )
+{
+    if (v -> spareCount < SPARE_VIEWS) {
+        v -> spares[v -> spareCount++] = view;
+        return;
+    }
+    int oldest = 0;
+    for (int i = 1; i < v -> spareCount; i++) {
+        if (v -> spares[i] -> number < v -> spares[oldest] -> number) {
+            oldest = i;
+        }
+    }
+    if (v -> spares[oldest] -> number < view -> number) {
+        freeCopies(v -> spares[oldest]);
+        v -> spares[oldest] = view;
+    }
+    else {
+        freeCopies(view);
+    }
+}
+
+/**
+    Takes the newest spare, which has the least to copy to catch up with the group.
+    @param *v the versions of the group
+    @return the spare, or NULL if there isn't one
+ */
+static ReadView *takeSpare( Versions *v )
+{
+    if (v -> spareCount == 0) {
+        return NULL;
+    }
+    int newest = 0;
+    for (int i = 1; i < v -> spareCount; i++) {
+        if (v -> spares[i] -> number > v -> spares[newest] -> number) {
+            newest = i;
+        }
+    }
+    ReadView *view = v -> spares[newest];
+    v -> spares[newest] = v -> spares[--v -> spareCount];
+    return view;
+}
+
+/**
+    Sets aside a view that nothing holds any more as a spare, and reuses the records that no remaining view
+    can see.
+    @param *group the group the view is of
+    @param *view the view
+ */
+static void freeView( Group *group, ReadView *view )
+{
+    Versions *v = group -> versions;
+    if (view -> older != NULL) {
+        view -> older -> newer = view -> newer;
+    }
+    else {
+        v -> oldest = view -> newer;
+    }
+    if (view -> newer != NULL) {
+        view -> newer -> older = view -> older;
+    }
+    else {
+        v -> newest = view -> older;
+    }
+    keepSpare(v, view);
+
+    // a record replaced while view n was the newest can be seen by views up to n
+    int kept = 0;
+    for (int i = 0; i < v -> retiredCount; i++) {
+        Retired r = v -> retired[i];
+        if (v -> oldest != NULL && v -> oldest -> number <= r.number) {
+            v -> retired[kept++] = r;
+        }
+        else if (r.owned) {
+            free(r.record);
+        }
+        else if (r.size > 0) {
+            arenaRelease(&group -> arena, r.record, r.size);
+        }
+    }
+    v -> retiredCount = kept;
+}
+
+/**
+    Frees what a group keeps for its views. Every view taken with acquireView must have been released.
+    @param *group the group
+ */
+void freeVersions( Group *group )
+{
+    Versions *v = group -> versions;
+    if (v -> current != NULL) {
+        releaseView(group, v -> current);
+    }
+    for (int i = 0; i < v -> spareCount; i++) {
+        freeCopies(v -> spares[i]);
+    }
+    free(v -> memberStamps);
+    free(v -> retired);
+    free(v -> items.stamps);
+    free(v -> members.stamps);
+    free(v -> sellers.stamps);
+    free(v);
+    group -> sellers.changing = NULL;
+    group -> sellers.changingArg = NULL;
+    group -> versions = NULL;
+}
+
+/**
+    Takes a view of the group as it is now. A view is only made when the group has changed since the last
+    one, so commands between two sales all share a view.
+    @param *group the group
+    @return the view, to be given back with releaseView
+ */
+ReadView *acquireView( Group *group )
+{
+    Versions *v = group -> versions;
+    if (v -> current == NULL) {
+        ReadView *view = takeSpare(v);
+        Group spare = { 0 };
+        long long since = 0;
+        if (view != NULL) {
+            spare = *view -> group;
+            // a spare made before a reload can't be caught up chunk by chunk
+            since = view -> number > v -> reshaped ? view -> number : 0;
+        }
+        else {
+            view = allocView(sizeof(ReadView));
+            view -> group = allocView(sizeof(Group));
+        }
+        Group *copy = view -> group;
+        *copy = *group;
+        copy -> itemSold = refreshCopy(spare.itemSold, spare.iCount, group -> itemSold, group -> iCount,
+                                       sizeof(long long), &v -> items, since);
+        copy -> itemRevenue = refreshCopy(spare.itemRevenue, spare.iCount, group -> itemRevenue, group -> iCount,
+                                          sizeof(long long), &v -> items, since);
+        copy -> mList = refreshCopy(spare.mList, spare.mCount, group -> mList, group -> mCount, sizeof(Member *),
+                                    &v -> members, since);
+        copy -> sellers.nodes = refreshCopy(spare.sellers.nodes, spare.sellers.count, group -> sellers.nodes,
+                                            group -> sellers.count, sizeof(LeaderNode), &v -> sellers, since);
+        copy -> sellers.cap = group -> sellers.count;
+        copy -> sellers.changing = NULL;
+        view -> number = ++v -> published;
+        // one reference is the cache's, given back when the group next changes
+        view -> refs = 1;
+        view -> older = v -> newest;
+        view -> newer = NULL;
+        if (v -> newest != NULL) {
+            v -> newest -> newer = view;
+        }
+        else {
+            v -> oldest = view;
+        }
+        v -> newest = view;
+        v -> current = view;
+    }
+    v -> current -> refs++;
+    return v -> current;
+}
+
+/**
+    Gives back a view taken with acquireView. Once no view can be reading a replaced record any more, the
+    record's storage is reused.
+    @param *group the group the view is of
+    @param *view the view
+ */
+void releaseView( Group *group, ReadView *view )
+{
+    if (--view -> refs == 0) {
+        freeView(group, view);
+    }
+}
+
+/**
+    Notes that the group is about to change, so the cached view no longer matches it.
+    @param *v the versions of the group
+    @param *group the group
+ */
+static void groupChanging( Versions *v, Group *group )
+{
+    if (v -> current != NULL) {
+        ReadView *view = v -> current;
+        v -> current = NULL;
+        releaseView(group, view);
+    }
+}
+
+/**
+    Sets a record aside until no view can still be reading it.
+    @param *v the versions of the group
+    @param *record the record
+    @param size the size of its block, or 0 if it didn't come from arenaBlock and can't be reused
+    @param owned true if the record came from malloc and is freed rather than reused
+ */
+static void retire( Versions *v, void *record, size_t size, bool owned )
+{
+    if (v -> retiredCount == v -> retiredCap) {
+        v -> retiredCap = v -> retiredCap == 0 ? INITIAL_SIZE : v -> retiredCap * DOUBLE_SIZE;
+        Retired *grown = realloc(v -> retired, v -> retiredCap * sizeof(Retired));
+        if (grown == NULL) {
+            fprintf(stderr, "Memory allocation issue.\n");
+            exit(EXIT_FAILURE);
+        }
+        v -> retired = grown;
+    }
+    v -> retired[v -> retiredCount].record = record;
+    v -> retired[v -> retiredCount].size = size;
+    v -> retired[v -> retiredCount].owned = owned;
+    v -> retired[v -> retiredCount].number = v -> newest -> number;
+    v -> retiredCount++;
+}
+
+/**
+    Notes that an item's sold and revenue totals are about to be written, so the next view copies them again.
+    @param *group the group
+    @param index the position of the item in the item list
+ */
+void itemChanging( Group *group, int index )
+{
+    Versions *v = group -> versions;
+    groupChanging(v, group);
+    noteChange(&v -> items, index, v -> published);
+}
+
+/**
+    Copies a record if a view may be reading it. A record stamped n was made when view n was the newest,
+    so only views after n can see it. There must be a view.
+    @param *group the group
+    @param *stamp the stamp of the record, updated if it is copied
+    @param *record the record
+    @param size the size of the record
+    @return the record to write, which is a copy if the record had to be kept
+ */
+static void *writable( Group *group, long long *stamp, void *record, size_t size )
+{
+    Versions *v = group -> versions;
+    if (v -> newest -> number <= *stamp) {
+        return record;
+    }
+    void *copy = arenaBlock(&group -> arena, blockSize(size));
+    memcpy(copy, record, size);
+    // only copies came from arenaBlock, the records from loading are left in the arena
+    retire(v, record, *stamp > 0 ? blockSize(size) : 0, false);
+    *stamp = v -> published;
+    return copy;
+}
+
+/**
+    Returns a member's record ready to be written: the record itself, or a copy that takes its place in the
+    group and in its leaderboard if a view may be reading it. A copy gets a copy of the sales list too, since
+    a sale writes the list in place and gives it back to the arena when it outgrows it.
+    @param *group the group
+    @param *m the member's record
+    @return the record to write
+ */
+Member *writableMember( Group *group, Member *m )
+{
+    groupChanging(group -> versions, group);
+    if (group -> versions -> newest == NULL) {
+        return m;
+    }
+    int index = findMemberIndex(group, m -> memberId);
+    long long *stamp = &group -> versions -> memberStamps[index];
+    bool loaded = *stamp == 0;
+    Member *copy = writable(group, stamp, m, sizeof(Member));
+    if (copy != m && m -> soldItemCap > 0) {
+        size_t size = m -> soldItemCap * sizeof(SaleItem);
+        copy -> soldItems = arenaBlock(&group -> arena, size);
+        memcpy(copy -> soldItems, m -> soldItems, m -> soldItemCount * sizeof(SaleItem));
+        // a list from loading may be in the snapshot, so like its record it is left where it is
+        retire(group -> versions, m -> soldItems, loaded ? 0 : size, false);
+    }
+    group -> mList[index] = copy;
+    group -> sellers.nodes[copy -> boardSlot].member = copy;
+    noteChange(&group -> versions -> members, index, group -> versions -> published);
+    noteChange(&group -> versions -> sellers, copy -> boardSlot, group -> versions -> published);
+    return copy;
+}
+
+/**
+    Frees storage a group has stopped using, such as an index a reload replaced. If a view may still be reading
+    it, it is set aside until no view can. Storage in the group's snapshot goes with the snapshot instead.
+    Since only a reload replaces storage, the next view is copied whole.
+    @param *group the group
+    @param *storage the storage, from malloc or the snapshot, or NULL
+ */
+void retireStorage( Group *group, void *storage )
+{
+    Versions *v = group -> versions;
+    if (v != NULL) {
+        groupChanging(v, group);
+        v -> reshaped = v -> published;
+    }
+    if (storage == NULL || inSnapshot(group, storage)) {
+        return;
+    }
+    if (v == NULL) {
+        free(storage);
+        return;
+    }
+    if (v -> newest == NULL) {
+        free(storage);
+    }
+    else {
+        retire(v, storage, 0, true);
+    }
+}
+
+/**
+    Moves the stamps of the member records to follow the records into a new member list, after a reload.
+    The next view is copied whole.
+    @param *group the group
+    @param *from the position in the old member list of each member of the new one, or -1 for a new member
+    @param count the number of members in the new list
+ */
+void moveMemberStamps( Group *group, int const *from, int count )
+{
+    Versions *v = group -> versions;
+    groupChanging(v, group);
+    v -> reshaped = v -> published;
+    long long *stamps = calloc(count + 1, sizeof(long long));
+    if (stamps == NULL) {
+        fprintf(stderr, "Memory allocation issue.\n");
+        exit(EXIT_FAILURE);
+    }
+    // a new member's record was made for the new list, so it is treated like a record from loading
+    for (int i = 0; i < count; i++) {
+        stamps[i] = from[i] < 0 ? 0 : v -> memberStamps[from[i]];
+    }
+    free(v -> memberStamps);
+    v -> memberStamps = stamps;
+}
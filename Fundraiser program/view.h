@@ -0,0 +1,136 @@
+/**
+    @file view.h
+    @author Sachi Vyas (smvyas)
+    A program that: The prototype for view.c
+ */
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+
+#ifndef VIEW_H
+#define VIEW_H
+
+struct GroupStruct;
+struct MemberStruct;
+
+/**
+    Struct for an unchanging copy of a group as it was at one moment, for commands that only read it. The
+    copy shares the group's names and indexes, which only a reload replaces, and has its own copies of the
+    item sold and revenue columns, the leaderboard's nodes and a member list that points at the member records
+    as they were. Once a view is made those records are never written again; a sale writes a fresh copy of a
+    record instead, and a reload sets the names and indexes it replaces aside until no view can see them.
+ */
+struct ReadViewStruct {
+    struct GroupStruct *group;
+    long long number;
+    int refs;
+    struct ReadViewStruct *older;
+    struct ReadViewStruct *newer;
+};
+typedef struct ReadViewStruct ReadView;
+
+/** Struct for a record replaced by a copy, or storage a reload replaced, kept until no view can still read it */
+struct RetiredStruct {
+    void *record;
+    size_t size;
+    bool owned;
+    long long number;
+};
+typedef struct RetiredStruct Retired;
+
+/**
+    Struct for when each chunk of an array that views copy was last written: a chunk stamped n was written
+    after view n was made, so a copy made for view n or earlier must take it again.
+ */
+struct ChangesStruct {
+    long long *stamps;
+    int chunks;
+    int shift;
+};
+typedef struct ChangesStruct Changes;
+
+/** Most given back views kept so the next view can reuse their copies */
+#define SPARE_VIEWS 4
+
+/**
+    Struct for the views of a group and the record copies made because of them. The copies of views that
+    were given back are kept as spares, and a new view starts from the newest spare and copies only the chunks
+    written since, unless a reload has changed the group since that spare was made.
+ */
+struct VersionsStruct {
+    long long published;
+    long long *memberStamps;
+    ReadView *current;
+    ReadView *oldest;
+    ReadView *newest;
+    Retired *retired;
+    int retiredCount;
+    int retiredCap;
+    Changes items;
+    Changes members;
+    Changes sellers;
+    long long reshaped;
+    ReadView *spares[SPARE_VIEWS];
+    int spareCount;
+};
+typedef struct VersionsStruct Versions;
+
+/**
+    Starts keeping views of a group, so commands that only read can run on other threads while sales
+    are made. Only the thread making sales may call the functions of this file.
+    @param *group the group
+ */
+void enableVersions( struct GroupStruct *group );
+/**
+    Frees what a group keeps for its views. Every view taken with acquireView must have been released.
+    @param *group the group
+ */
+void freeVersions( struct GroupStruct *group );
+/**
+    Takes a view of the group as it is now. A view is only made when the group has changed since the last
+    one, so commands between two sales all share a view, and it is made from a spare by copying only what
+    changed since the spare was made.
+    @param *group the group
+    @return the view, to be given back with releaseView
+ */
+ReadView *acquireView( struct GroupStruct *group );
+/**
+    Gives back a view taken with acquireView. Once no view can be reading a replaced record any more, the
+    record's storage is reused.
+    @param *group the group the view is of
+    @param *view the view
+ */
+void releaseView( struct GroupStruct *group, ReadView *view );
+/**
+    Notes that an item's sold and revenue totals are about to be written, so the next view copies them again.
+    @param *group the group
+    @param index the position of the item in the item list
+ */
+void itemChanging( struct GroupStruct *group, int index );
+/**
+    Returns a member's record ready to be written: the record itself, or a copy that takes its place in the
+    group and in its leaderboard if a view may be reading it. A copy gets a copy of the sales list too, since
+    a sale writes the list in place and gives it back to the arena when it outgrows it.
+    @param *group the group
+    @param *m the member's record
+    @return the record to write
+ */
+struct MemberStruct *writableMember( struct GroupStruct *group, struct MemberStruct *m );
+/**
+    Frees storage a group has stopped using, such as an index a reload replaced. If a view may still be reading
+    it, it is set aside until no view can. Storage in the group's snapshot goes with the snapshot instead.
+    Since only a reload replaces storage, the next view is copied whole.
+    @param *group the group
+    @param *storage the storage, from malloc or the snapshot, or NULL
+ */
+void retireStorage( struct GroupStruct *group, void *storage );
+/**
+    Moves the stamps of the member records to follow the records into a new member list, after a reload.
+    The next view is copied whole.
+    @param *group the group
+    @param *from the position in the old member list of each member of the new one, or -1 for a new member
+    @param count the number of members in the new list
+ */
+void moveMemberStamps( struct GroupStruct *group, int const *from, int count );
+
+#endif
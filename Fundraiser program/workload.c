@@ -0,0 +1,310 @@
+/**
+    @file workload.c
+    @author Sachi Vyas (smvyas)
+    A program that: Generates an item file, a member file and a stream of commands of any size, so the
+    fundraiser program can be measured on more than the handful of test files.
+ */
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+
+/** Number of command line arguments needed, counting the program name */
+#define MIN_ARGS 7
+/** Seed used when none is given */
+#define DEFAULT_SEED 1
+/** Longest name the fundraiser program accepts */
+#define MAX_NAME_LEN 30
+/** Longest member id the fundraiser program accepts */
+#define MAX_ID_LEN 8
+/** Longest file name made from the prefix */
+#define MAX_PATH_LEN 1024
+/** Most an item can cost */
+#define MAX_COST 50
+/** Most of an item sold in one sale */
+#define MAX_QUANTITY 20
+/** Shortest search string generated */
+#define MIN_SEARCH_LEN 3
+/** Longest search string generated */
+#define MAX_SEARCH_LEN 6
+/** Number of letters and digits used in member ids */
+#define ID_BASE 36
+/** Number of different list commands, counting list member */
+#define LIST_KINDS 7
+/** Number of different search commands */
+#define SEARCH_KINDS 4
+/** First shift of the random number generator */
+#define XORSHIFT_A 13
+/** Second shift of the random number generator */
+#define XORSHIFT_B 7
+/** Third shift of the random number generator */
+#define XORSHIFT_C 17
+
+/** Words used to make item names */
+static char const *const adjectives[] = {
+    "Red", "Blue", "Green", "Large", "Small", "Holiday", "Classic", "Deluxe",
+    "Scented", "Glass", "Wooden", "Assorted", "Mini", "Family", "Gift", "Golden"
+};
+/** Words used to make item names */
+static char const *const nouns[] = {
+    "candle", "mug", "calendar", "cards", "candy", "wreath", "popcorn", "cookies",
+    "ornament", "pen set", "tote bag", "blanket", "cocoa", "planner", "puzzle", "soap"
+};
+/** Words used to make member names */
+static char const *const firstNames[] = {
+    "Susan", "Mary", "Thomas", "Sarah", "Sam", "Manuel", "Min", "Ann",
+    "James", "Priya", "Omar", "Lena", "Carlos", "Grace", "Wei", "Noah"
+};
+/** Words used to make member names */
+static char const *const lastNames[] = {
+    "Shaw", "Brinkley", "Brady", "Patel", "Parker", "Dominguez", "Zhang", "Bradley",
+    "Nguyen", "Okafor", "Rossi", "Kim", "Garcia", "Novak", "Silva", "Hughes"
+};
+/** The list commands that take no argument, list member is made separately */
+static char const *const listCommands[] = {
+    "list items", "list item names", "list members", "list member names", "list topsellers", "list topsellers 10"
+};
+/** The search commands, each followed by a search string */
+static char const *const searchCommands[] = {
+    "search item", "search member", "search ignorecase item", "search ignorecase member"
+};
+
+/** State of the random number generator */
+static unsigned long long randomState = DEFAULT_SEED;
+
+/**
+    Returns the next number from a xorshift generator, so the same seed makes the same files everywhere.
+    @return a pseudo-random number
+ */
+static unsigned long long nextRandom( void )
+{
+    randomState ^= randomState << XORSHIFT_A;
+    randomState ^= randomState >> XORSHIFT_B;
+    randomState ^= randomState << XORSHIFT_C;
+    return randomState;
+}
+
+/**
+    Returns a pseudo-random number below a bound.
+    @param bound one more than the largest number wanted
+    @return a number from 0 to bound - 1
+ */
+static long long randomBelow( long long bound )
+{
+    return (long long)(nextRandom() % (unsigned long long) bound);
+}
+
+/**
+    Returns the number of entries in one of the word lists.
+    @param size the size of the list in bytes
+    @return the number of entries
+ */
+static int countOf( size_t size )
+{
+    return (int)(size / sizeof(char const *));
+}
+
+/**
+    Makes the id of a member from its number, as a letter followed by the number in base 36.
+    @param *id the place to store the id, with room for MAX_ID_LEN characters and a null terminator
+    @param number the number of the member
+ */
+static void memberId( char *id, long long number )
+{
+    char digits[MAX_ID_LEN];
+    int len = 0;
+    do {
+        long long d = number % ID_BASE;
+        digits[len++] = d < 10 ? '0' + d : 'a' + d - 10;
+        number /= ID_BASE;
+    } while (number != 0 && len < MAX_ID_LEN - 1);
+    id[0] = 'm';
+    for (int i = 0; i < len; i++) {
+        id[i + 1] = digits[len - 1 - i];
+    }
+    id[len + 1] = '\0';
+}
+
+/**
+    Makes the name of an item from its number.
+    @param *name the place to store the name, with room for MAX_NAME_LEN characters and a null terminator
+    @param number the number of the item
+ */
+static void itemName( char *name, long long number )
+{
+    snprintf(name, MAX_NAME_LEN + 1, "%s %s %lld", adjectives[number % countOf(sizeof(adjectives))],
+             nouns[number / countOf(sizeof(adjectives)) % countOf(sizeof(nouns))], number);
+}
+
+/**
+    Makes the name of a member from its number.
+    @param *name the place to store the name, with room for MAX_NAME_LEN characters and a null terminator
+    @param number the number of the member
+ */
+static void memberName( char *name, long long number )
+{
+    snprintf(name, MAX_NAME_LEN + 1, "%s %s", firstNames[number % countOf(sizeof(firstNames))],
+             lastNames[number / countOf(sizeof(firstNames)) % countOf(sizeof(lastNames))]);
+}
+
+/**
+    Copies a random piece of a name, without spaces, to search for. Every so often the case of some of its
+    letters is changed, which only searches that ignore case will see past.
+    @param *str the place to store the search string, with room for MAX_SEARCH_LEN characters and a null
+    @param *name the name to take it from
+    @param mixCase true to change the case of some letters
+ */
+static void searchString( char *str, char const *name, bool mixCase )
+{
+    int nameLen = strlen(name);
+    int start = randomBelow(nameLen);
+    int len = MIN_SEARCH_LEN + randomBelow(MAX_SEARCH_LEN - MIN_SEARCH_LEN + 1);
+    int n = 0;
+    for (int i = start; i < nameLen && n < len && name[i] != ' '; i++) {
+        str[n++] = name[i];
+    }
+    if (n == 0) {
+        str[n++] = name[0];
+    }
+    str[n] = '\0';
+    for (int i = 0; mixCase && i < n; i++) {
+        if (randomBelow(2) == 0 && str[i] >= 'a' && str[i] <= 'z') {
+            str[i] -= 'a' - 'A';
+        }
+    }
+}
+
+/**
+    Opens one of the files being generated, exiting if it can't be made.
+    @param *prefix the prefix for the file names
+    @param *suffix the rest of the file name
+    @return the open file
+ */
+static FILE *openOutput( char const *prefix, char const *suffix )
+{
+    char path[MAX_PATH_LEN];
+    snprintf(path, sizeof(path), "%s%s", prefix, suffix);
+    FILE *fp = fopen(path, "w");
+    if (fp == NULL) {
+        fprintf(stderr, "Can't create file: %s\n", path);
+        exit(EXIT_FAILURE);
+    }
+    return fp;
+}
+
+/**
+    Parses a count from the command line, exiting if it isn't one.
+    @param *arg the argument
+    @return the count
+ */
+static long long parseCount( char const *arg )
+{
+    char *end;
+    long long n = strtoll(arg, &end, 10);
+    if (*arg == '\0' || *end != '\0' || n < 0) {
+        fprintf(stderr, "Invalid count: %s\n", arg);
+        exit(EXIT_FAILURE);
+    }
+    return n;
+}
+
+/**
+    Writes <prefix>items.txt, <prefix>members.txt and <prefix>commands.txt. The commands are the given numbers
+    of sales, list commands and search commands, shuffled together and followed by quit.
+    @param argc the number of arguments in the command line
+    @param argv the arguments: prefix, items, members, sales, lists, searches and an optional seed
+    @return 0 if the files were written
+ */
+int main( int argc, char *argv[] )
+{
+    if (argc < MIN_ARGS) {
+        fprintf(stderr, "usage: workload prefix items members sales lists searches [seed]\n");
+        exit(EXIT_FAILURE);
+    }
+    char const *prefix = argv[1];
+    long long items = parseCount(argv[2]);
+    long long members = parseCount(argv[3]);
+    long long sales = parseCount(argv[4]);
+    long long lists = parseCount(argv[5]);
+    long long searches = parseCount(argv[6]);
+    if (argc > MIN_ARGS) {
+        randomState = parseCount(argv[MIN_ARGS]) * 2 + 1;
+    }
+    if (items == 0 || members == 0) {
+        fprintf(stderr, "There must be at least one item and one member\n");
+        exit(EXIT_FAILURE);
+    }
+
+    // item ids are 1 to items, written in shuffled order so the program has to sort them
+    int *ids = (int *)malloc(items * sizeof(int));
+    if (ids == NULL) {
+        fprintf(stderr, "Memory allocation issue.\n");
+        exit(EXIT_FAILURE);
+    }
+    for (long long i = 0; i < items; i++) {
+        ids[i] = (int)(i + 1);
+    }
+    for (long long i = items - 1; i > 0; i--) {
+        long long j = randomBelow(i + 1);
+        int swap = ids[i];
+        ids[i] = ids[j];
+        ids[j] = swap;
+    }
+
+    char name[MAX_NAME_LEN + 1];
+    char id[MAX_ID_LEN + 1];
+    FILE *fp = openOutput(prefix, "items.txt");
+    for (long long i = 0; i < items; i++) {
+        itemName(name, ids[i]);
+        fprintf(fp, "%d %lld %s\n", ids[i], 1 + randomBelow(MAX_COST), name);
+    }
+    fclose(fp);
+
+    fp = openOutput(prefix, "members.txt");
+    for (long long i = 0; i < members; i++) {
+        memberId(id, i);
+        memberName(name, i);
+        fprintf(fp, "%s %s\n", id, name);
+    }
+    fclose(fp);
+
+    // pick each command with a chance in proportion to how many of its kind are left, which spreads the
+    // lists and searches evenly through the sales
+    fp = openOutput(prefix, "commands.txt");
+    char str[MAX_SEARCH_LEN + 1];
+    while (sales + lists + searches > 0) {
+        long long pick = randomBelow(sales + lists + searches);
+        if (pick < sales) {
+            memberId(id, randomBelow(members));
+            fprintf(fp, "sale %s %lld %lld\n", id, 1 + randomBelow(items), 1 + randomBelow(MAX_QUANTITY));
+            sales--;
+        }
+        else if (pick < sales + lists) {
+            int kind = randomBelow(LIST_KINDS);
+            if (kind < countOf(sizeof(listCommands))) {
+                fprintf(fp, "%s\n", listCommands[kind]);
+            }
+            else {
+                memberId(id, randomBelow(members));
+                fprintf(fp, "list member %s\n", id);
+            }
+            lists--;
+        }
+        else {
+            int kind = randomBelow(SEARCH_KINDS);
+            if (kind % 2 == 0) {
+                itemName(name, 1 + randomBelow(items));
+            }
+            else {
+                memberName(name, randomBelow(members));
+            }
+            searchString(str, name, kind >= 2);
+            fprintf(fp, "%s %s\n", searchCommands[kind], str);
+            searches--;
+        }
+    }
+    fprintf(fp, "quit\n");
+    fclose(fp);
+    free(ids);
+    return EXIT_SUCCESS;
+}